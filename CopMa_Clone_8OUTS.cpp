@@ -44,12 +44,15 @@ SOFTWARE.
 
 
 
+#include <atomic>
 #include <cmath>
 #include <cstring>
 #include <distingnt/api.h>
 
 // --- Constants for buffer and scale definitions ---
-#define ASR_BUF_SIZE 64 // Max buffer length for the analog shift register (ASR)
+#define ASR_MIN_SIZE 16      // Smallest ASR capacity an instance can be created with
+#define ASR_MAX_SIZE 4096    // Largest ASR capacity an instance can be created with
+#define ASR_DEFAULT_SIZE 64  // Default ASR capacity (slots)
 #define NUM_STAGES 8    // Number of output stages (A, B, C, D, E, F, G, H)
 #define NUM_STANDARD_SCALES 16
 #define NUM_EXOTIC_SCALES 117
@@ -448,8 +451,10 @@ static const char* bytebeat_cv1_dest_names[] = {
     "igain", "eqn", "P0", "P1", "P2"
 };
 #define NUM_BYTEBEAT_CV1_DEST 5
+#define BYTEBEAT_RATE_UNIT 100      // BB Rate step in Hz; classic bytebeat runs at 8 kHz
+#define BYTEBEAT_LPF_HZ 4000.0f     // Corner of the optional BB Out lowpass
 
-float bytebeat(int eqn, int t, int p0, int p1, int p2) {
+float bytebeat(int eqn, uint32_t t, int p0, int p1, int p2) {
     switch (eqn) {
         case 0: return ((t * (t >> 8)) & 0xFF) / 128.0f - 1.0f; // hope
         case 1: return ((t ^ (t >> 3)) & 0xFF) / 128.0f - 1.0f; // love
@@ -477,19 +482,323 @@ struct IntSeqState {
     int dir; // 1 = forward, -1 = backward
 };
 
+// --- MIDI output ---
+#define MIDI_NOTE_ZERO_V 48 // MIDI note sent for a 0V stage output
+
+static const char* midi_dest_names[] = {
+    "Breakout", "Select Bus", "USB", "Internal", "All"
+};
+#define NUM_MIDI_DESTS 5
+
+static const uint32_t midi_dest_flags[NUM_MIDI_DESTS] = {
+    kNT_destinationBreakout, kNT_destinationSelectBus, kNT_destinationUSB, kNT_destinationInternal,
+    kNT_destinationBreakout | kNT_destinationSelectBus | kNT_destinationUSB | kNT_destinationInternal
+};
+
+// Note currently sounding on each stage's MIDI channel
+struct MidiOutState {
+    int8_t note[NUM_STAGES];    // -1 = no note on
+    int8_t channel[NUM_STAGES]; // 0-based channel the note was sent on
+};
+
+// --- MIDI input ---
+// Note-ons are handed from midiMessage() to step() through a single
+// producer, single consumer ring; a full ring drops the newest note.
+#define MIDI_IN_OFF 0
+#define MIDI_IN_NOTE_ON 1   // Each note-on is written into the ASR
+#define MIDI_IN_CLOCKED 2   // The last note-on replaces the source on clock edges
+#define MIDI_QUEUE_SIZE 16  // Power of two
+
+struct MidiInQueue {
+    uint8_t note[MIDI_QUEUE_SIZE];
+    std::atomic<uint32_t> head; // Next slot to write, only stored by the producer
+    std::atomic<uint32_t> tail; // Next slot to read, only stored by the consumer
+};
+
+inline bool midi_queue_push(MidiInQueue& q, uint8_t note) {
+    uint32_t head = q.head.load(std::memory_order_relaxed);
+    if (head - q.tail.load(std::memory_order_acquire) == MIDI_QUEUE_SIZE) return false;
+    q.note[head & (MIDI_QUEUE_SIZE - 1)] = note;
+    q.head.store(head + 1, std::memory_order_release);
+    return true;
+}
+
+inline bool midi_queue_pop(MidiInQueue& q, uint8_t& note) {
+    uint32_t tail = q.tail.load(std::memory_order_relaxed);
+    if (tail == q.head.load(std::memory_order_acquire)) return false;
+    note = q.note[tail & (MIDI_QUEUE_SIZE - 1)];
+    q.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+// --- Tap patterns ---
+// Stage s reads BufIdx * step[s] slots behind the newest one; the User pattern
+// takes the offsets from the Tap parameters instead.
+static const char* tap_pattern_names[] = {
+    "Linear", "Fib", "Prime", "User"
+};
+#define NUM_TAP_PATTERNS 4
+#define TAP_PATTERN_USER 3
+
+static const uint8_t tap_pattern_steps[TAP_PATTERN_USER][NUM_STAGES] = {
+    { 1, 2, 3, 4, 5, 6, 7, 8 },       // Linear
+    { 1, 2, 3, 5, 8, 13, 21, 34 },    // Fibonacci
+    { 2, 3, 5, 7, 11, 13, 17, 19 }   // Prime
+};
+
+// --- Scale periods ---
+// Exotic rows hold their degrees in twelfths of the scale's period. The
+// Bohlen-Pierce and HD3 rows at the end of the table repeat at the tritave.
+#define NUM_TRITAVE_SCALES 13
+#define TRITAVE_SEMITONES 19.01955f
+
+inline float scale_period(int scaleIdx) {
+    return (scaleIdx >= NUM_SCALES - NUM_TRITAVE_SCALES && scaleIdx < NUM_SCALES) ? TRITAVE_SEMITONES : 12.0f;
+}
+
+// --- Derived quantizer table ---
+// For octave scales quantization only depends on the pitch class of the incoming
+// note, which is n % 12 in -11..11, so the nearest scale note is resolved once
+// per setting, in semitones and, for pitch classes 0..11, in volts. Other periods are folded with a reciprocal multiply, and a bin
+// table narrows the nearest degree down to one or two compares.
+#define QTABLE_SIZE 23
+#define PERIOD_BINS_PER_SEMITONE 4
+#define PERIOD_MAX_BINS 80
+struct QuantTable {
+    int8_t offset[QTABLE_SIZE]; // Octave scales: nearest enabled note (semitones) for pitch class (n % 12) + 11
+    float pcVolts[12];          // Octave scales: the same for pitch classes 0..11, in volts
+    bool periodic;              // Period is not the octave
+    float period;               // Semitones
+    float invPeriod;
+    // Distinct degrees within the period, ascending, followed by the first
+    // one a period up and an infinite sentinel
+    float degrees[SCALE_MAX_LEN + 2];
+    int8_t numDegrees;
+    uint8_t bin[PERIOD_MAX_BINS]; // Periodic scales: last degree at or below each bin start
+};
+
+// Scale morphing steps from Scale to Scale B, both ends included
+#define MORPH_STEPS 16
+
+// --- Display columns ---
+// Up to DISP_COLS slots get a column each; longer buffers share columns.
+#define DISP_COLS 64
+
+inline int disp_column(int slot, int bufLen) {
+    return bufLen <= DISP_COLS ? slot : (slot * DISP_COLS) / bufLen;
+}
+
+// --- Display layout ---
+#define DISP_COL_W 4       // Pixels per column, DISP_COLS columns span the 256 pixel screen
+#define DISP_LABEL_Y 21    // Baseline of the scale/root/index label row
+#define DISP_TAP_Y 28      // Baseline of the stage letter row
+#define DISP_BAR_TOP 30
+#define DISP_BAR_MID 46    // 0V line of the slot bars
+#define DISP_BAR_BOTTOM 61
+#define DISP_HEAD_Y 63     // Frame line carrying the write head marker
+
+// draw() owns the full-width rows from the label row down to the frame line
+#define DISP_TOP (DISP_LABEL_Y - 6)
+#define DISP_ROW_BYTES 128 // Two 4-bit pixels per byte
+#define DISP_REGION_BYTES ((DISP_HEAD_Y + 1 - DISP_TOP) * DISP_ROW_BYTES)
+
+// --- Display cache: what draw() last put on screen ---
+struct DisplayState {
+    int bufLen;                 // Buffer length the columns were laid out for
+    int headCol;                // Column under the write head marker, -1 if none
+    int tapCol[NUM_STAGES];     // Columns under the tap letters
+    int scale, root, transpose, bufIdx; // Values shown in the label row
+    int fit;                    // Detected fit shown in place of the scale, -1 if none
+    bool labelsValid;
+    bool profiling;             // Label row shows the step profile
+    uint32_t profileCycles;     // Profile shown, valid while profiling
+    bool drawn;                 // The saved region holds the last frame
+    int ops;                    // Draw primitives issued by the last draw()
+    int maxOps;                 // Worst case seen since construction
+};
+
+// --- Step profile ---
+// Slowest step() since Profile was switched on; only shown, never acted on
+struct StepProfile {
+    uint32_t cycles;            // CPU cycles of the slowest block
+    int frames, edges;          // Block size and clock edges in it
+    int scale, cvSource, bufLen, mode;
+};
+
+// --- Scale detection ---
+// Latched samples feed a decaying pitch-class histogram. Every octave scale is
+// a 12-bit template of its pitch classes; a scale at a root scores the weight
+// inside the rotated template minus its share (notes / 12) of the total, so
+// bigger scales gain nothing just for covering more notes. Each clock edge
+// scores DETECT_SCALES_PER_EDGE scales at all 12 roots against a snapshot
+// taken when the sweep began, so the cost per edge is fixed, and a finished
+// sweep's best fit becomes the suggestion.
+#define DETECT_OFF 0
+#define DETECT_SHOW 1
+#define DETECT_APPLY 2
+#define DETECT_SCALES_PER_EDGE 8
+#define DETECT_DECAY 0.96875f   // Histogram remembers about 32 edges
+struct DetectState {
+    float hist[12];             // Pitch-class weights
+    float total;                // Sum of hist
+    float snap[24];             // hist when the sweep began, repeated an octave up
+    float snapTotal;
+    uint16_t pcs[NUM_SCALES];   // Template of each scale, 0 for non-octave scales
+    int nextScale;              // Next scale the sweep scores
+    float sweepScore;           // Best fit of the sweep so far
+    int sweepFit;
+    std::atomic<int> fit;       // scale * 12 + root of the last finished sweep, -1 = none
+    int tableFit;               // Fit of the last published detect table, -1 = none
+};
+
+// --- Rarely touched state, placed in DRAM ahead of the ASR buffer ---
+struct CopierMaschineCold {
+    // Columns written by step() since draw() last showed them, one bit each
+    std::atomic<uint32_t> dirtyCols[DISP_COLS / 32];
+    DisplayState display;
+    uint8_t screen[DISP_REGION_BYTES]; // The display region as the last draw() left it
+    StepProfile profile;
+    QuantTable morph[2][MORPH_STEPS]; // Blended tables, double buffered
+    DetectState detect;
+    QuantTable detectTables[2]; // Detect Apply's table, double buffered
+};
+
+// --- Random source state ---
+struct RandomState {
+    uint32_t rng;   // xorshift32 state, never 0
+    int seed;       // Rnd Seed the generator was last seeded with, -1 = not yet
+    float value;    // Value drawn at the last clock edge
+};
+
+// --- Clock edge events ---
+// Every frame with a rising edge on some clock bus becomes one event, with
+// one bit per distinct bus clocking the block; bit 0 is the main Clock.
+#define NUM_BUSES 28
+#define CLOCK_SCAN_FRAMES 64    // Frames scanned ahead of processing at a time
+struct ClockEvent {
+    uint16_t frame;
+    uint16_t buses;
+};
+
+// --- Audio-rate ring ---
+// In Audio mode the ASR shifts every sample. Samples go into a ring of
+// capacity + AUDIO_CHUNK slots that is stored twice over, so any run of up to
+// one ring length reads as a single contiguous copy. The ring is only
+// reserved when the Audio mode specification is on.
+#define MODE_AUDIO 2
+#define AUDIO_CHUNK 32          // Frames written, then read, at a time
+
+inline int audio_ring_len(int capacity) {
+    return capacity + AUDIO_CHUNK;
+}
+
+// --- Stage inputs ---
+// What a set of stage values was worked out from, besides the ASR contents.
+// A table is rebuilt in place or comes back holding another setting, so every
+// table swap or rebuild clears table, which no longer matches anything.
+struct StageInputs {
+    int writePos, bufLen, offset;
+    const QuantTable* table;    // NULL = nothing recorded
+    bool harmony;
+    uint32_t cascade;
+    int tapOffset[NUM_STAGES];
+    int8_t harmDegree[NUM_STAGES];
+};
+
+// --- Clock look-ahead ---
+// Stage values the next main clock edge will produce, worked out in a block
+// without edges, with what they were worked out from.
+struct Lookahead {
+    uint32_t lastEdge;          // Frame count at the last main clock edge
+    uint32_t period;            // Frames between the last two edges, 0 = unknown
+    bool valid;
+    bool needsSample;           // Some stage reads the slot the edge writes
+    float sample;               // Sample predicted for that slot
+    StageInputs inputs;
+    float value[NUM_STAGES];
+};
+
 // --- State for the algorithm ---
+// Everything step() touches per sample or per edge, placed in DTC. The ASR
+// history itself lives in DRAM; stages read it only on edges and block starts.
 struct CopierMaschineState {
-    float buffer[ASR_BUF_SIZE]; // Circular buffer for ASR
+    float* buffer;              // Circular buffer for ASR (DRAM)
+    float* audioRing;           // Audio mode ring, mirrored (DRAM), NULL without the specification
+    int audioPos;               // Audio mode write position
+    CopierMaschineCold* cold;   // Display bookkeeping (DRAM)
+    int capacity;               // ASR slots allocated for this instance
     int bufLen;                 // Current buffer length
     int writePos;               // Current write position in buffer
-    float lastClock;            // Last clock value for edge detection
-    int t;                      // ByteBeat time counter
+    float lastClock[NUM_BUSES]; // Last value of each bus, for edge detection
+    uint64_t bbPhase;           // ByteBeat time, 32.32 fixed point
+    uint64_t bbInc;             // Phase increment per sample for BB Rate
+    uint32_t bbT;               // Integer time bbValue was evaluated at
+    float bbValue;              // Held ByteBeat output
+    float bbLpfCoef;            // BB LPF one-pole coefficient
+    float bbLpfOut;             // BB LPF state
     IntSeqState intseq;         // Integer Sequence state
-};
-
-// --- Algorithm struct ---
-struct _copierAlgorithm : public _NT_algorithm {
-    CopierMaschineState* state;
+    RandomState rnd;            // Random source state
+
+    // Per-stage glide, kept as arrays so all stages filter together. A
+    // coefficient of 1 means no glide.
+    float glideCoef[NUM_STAGES];
+    float glideOut[NUM_STAGES];   // Glided stage outputs
+
+    // Harmonizer: stages B.. sit harmDegree scale degrees above stage A
+    bool harmony;
+    int8_t harmDegree[NUM_STAGES];
+    float stageValue[NUM_STAGES]; // Cached quantized stage outputs
+    StageInputs stageInputs;      // What stageValue was worked out from
+    uint16_t tapIdx[NUM_STAGES];  // Slot each stage currently reads
+
+    // Tap offsets (slots behind the newest one, already reduced modulo bufLen)
+    // are only resolved when the pattern, the CV scan or bufLen change.
+    int tapOffset[NUM_STAGES];
+    int tapScan;                  // CV scan the offsets were resolved with
+    std::atomic<bool> tapsChanged; // Set by parameterChanged()
+    std::atomic<bool> busesAlias;  // An output shares a bus with CV In
+
+    // Cascade: stages with their own clock hold cascadeValue, latched from
+    // the previous stage on that clock, in place of their tap
+    uint32_t cascade;             // One bit per cascaded stage
+    float cascadeValue[NUM_STAGES];
+    MidiOutState midiOut;         // Notes sent by the MIDI outputs
+    MidiInQueue midiIn;           // Note-ons not yet seen by step()
+    float midiValue;              // Last received note (volts) for Clocked MIDI In
+
+    // Track mode: input range [binLo, binHi) over which the newest slot keeps
+    // trackNote, valid for trackTable and trackOffset.
+    float binLo, binHi;
+    float trackNote;            // Quantized note (semitones) of the newest slot
+    const QuantTable* trackTable;
+    int trackOffset;
+
+    // Quantizer tables: parameterChanged() fills the buffer step() is not
+    // reading and publishes it through pendingTable; step() swaps it in at the
+    // start of the next block.
+    QuantTable tables[2];
+    QuantTable* scaleTable;               // Only touched by step()
+    std::atomic<QuantTable*> pendingTable; // Finished table not yet picked up
+    QuantTable* lastPublished;            // Only touched by the publishing side
+
+    // Morph tables follow the same handoff with a plain double buffer
+    QuantTable* morphTables;              // Only touched by step()
+    std::atomic<QuantTable*> pendingMorph;
+    QuantTable* lastMorph;                // Only touched by the publishing side
+
+    // Detect Apply's table too, published by draw() once a sweep finishes
+    QuantTable* detectTable;              // Only touched by step(), NULL = no fit yet
+    std::atomic<QuantTable*> pendingDetect;
+    QuantTable* lastDetect;               // Only touched by the publishing side
+
+    // Table quantizing the current block: scaleTable, or one of morphTables
+    QuantTable* activeTable;
+
+    uint32_t frameCount;               // Frames processed, wrapping
+    Lookahead ahead;
+
+    uint32_t maxCycles;                // Slowest block while profiling
+    std::atomic<bool> profileReset;    // Set when Profile is switched on
 };
 
 // --- Parameter enum ---
@@ -525,6 +834,77 @@ enum {
     kParamIntSeqDir,
     kParamIntSeqStride,
     kParamIntSeqCV1Dest,
+    kParamMidiDest,
+    kParamMidiVel,
+    kParamMidiChA,
+    kParamMidiChB,
+    kParamMidiChC,
+    kParamMidiChD,
+    kParamMidiChE,
+    kParamMidiChF,
+    kParamMidiChG,
+    kParamMidiChH,
+    kParamMode,
+    kParamHyst,
+    kParamTapPattern,
+    kParamTapCV,
+    kParamTapA,
+    kParamTapB,
+    kParamTapC,
+    kParamTapD,
+    kParamTapE,
+    kParamTapF,
+    kParamTapG,
+    kParamTapH,
+    kParamRndSeed,
+    kParamRndLock,
+    kParamGlideA,
+    kParamGlideB,
+    kParamGlideC,
+    kParamGlideD,
+    kParamGlideE,
+    kParamGlideF,
+    kParamGlideG,
+    kParamGlideH,
+    kParamHarmony,
+    kParamDegB,
+    kParamDegC,
+    kParamDegD,
+    kParamDegE,
+    kParamDegF,
+    kParamDegG,
+    kParamDegH,
+    kParamByteBeatRate,
+    kParamMorph,
+    kParamScaleB,
+    kParamMorphAmt,
+    kParamMorphCV,
+    kParamNote1,       // 0=off, 1=on, one per scale degree 1..12
+    kParamNote2,
+    kParamNote3,
+    kParamNote4,
+    kParamNote5,
+    kParamNote6,
+    kParamNote7,
+    kParamNote8,
+    kParamNote9,
+    kParamNote10,
+    kParamNote11,
+    kParamNote12,
+    kParamProfile,
+    kParamBBOut,
+    kParamBBLpf,
+    kParamMidiIn,
+    kParamMidiInCh,
+    kParamDetect,
+    kParamClkB,
+    kParamClkC,
+    kParamClkD,
+    kParamClkE,
+    kParamClkF,
+    kParamClkG,
+    kParamClkH,
+    kParamAudioQuant,
     kNumParams
 };
 
@@ -544,11 +924,11 @@ static const _NT_parameter parameters[] = {
     { .name = "Root", .min = 0, .max = 11, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
     { .name = "Transpose", .min = -24, .max = 24, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
     { .name = "MaskRot", .min = 0, .max = 15, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
-    { .name = "BufIdx", .min = 0, .max = ASR_BUF_SIZE-1, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
-    { .name = "BufLen", .min = 4, .max = ASR_BUF_SIZE, .def = 16, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "BufIdx", .min = 0, .max = ASR_DEFAULT_SIZE-1, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "BufLen", .min = 4, .max = ASR_DEFAULT_SIZE, .def = 16, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
     { .name = "Hold", .min = 0, .max = 1, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
     { .name = "Gain", .min = 5, .max = 200, .def = 100, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
-    { .name = "CVSrc", .min = 0, .max = 2, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"CV", "ByteBeat", "IntSeq"} },
+    { .name = "CVSrc", .min = 0, .max = 3, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"CV", "ByteBeat", "IntSeq", "Random"} },
     { .name = "BB Eqn", .min = 0, .max = NUM_BYTEBEAT_EQNS-1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = bytebeat_names },
     { .name = "BB P0", .min = 0, .max = 255, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
     { .name = "BB P1", .min = 0, .max = 255, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
@@ -561,56 +941,648 @@ static const _NT_parameter parameters[] = {
     { .name = "IntSeqDir", .min = 0, .max = 1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"loop", "pendulum"} },
     { .name = "IntSeqStride", .min = 1, .max = 16, .def = 1, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
     { .name = "IntSeqCV1", .min = 0, .max = NUM_INTSEQ_CV1_DEST-1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = intseq_cv1_dest_names },
+    { .name = "MIDI Dest", .min = 0, .max = NUM_MIDI_DESTS-1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = midi_dest_names },
+    { .name = "MIDI Vel", .min = 1, .max = 127, .def = 100, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "MIDI Ch A", .min = 0, .max = 16, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "MIDI Ch B", .min = 0, .max = 16, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "MIDI Ch C", .min = 0, .max = 16, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "MIDI Ch D", .min = 0, .max = 16, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "MIDI Ch E", .min = 0, .max = 16, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "MIDI Ch F", .min = 0, .max = 16, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "MIDI Ch G", .min = 0, .max = 16, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "MIDI Ch H", .min = 0, .max = 16, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Mode", .min = 0, .max = 2, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Clocked", "Track", "Audio"} },
+    { .name = "Hyst", .min = 0, .max = 50, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "TapPat", .min = 0, .max = NUM_TAP_PATTERNS-1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = tap_pattern_names },
+    { .name = "Tap CV", .min = 0, .max = 28, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Tap A", .min = 0, .max = ASR_DEFAULT_SIZE-1, .def = 1, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Tap B", .min = 0, .max = ASR_DEFAULT_SIZE-1, .def = 2, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Tap C", .min = 0, .max = ASR_DEFAULT_SIZE-1, .def = 3, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Tap D", .min = 0, .max = ASR_DEFAULT_SIZE-1, .def = 4, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Tap E", .min = 0, .max = ASR_DEFAULT_SIZE-1, .def = 5, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Tap F", .min = 0, .max = ASR_DEFAULT_SIZE-1, .def = 6, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Tap G", .min = 0, .max = ASR_DEFAULT_SIZE-1, .def = 7, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Tap H", .min = 0, .max = ASR_DEFAULT_SIZE-1, .def = 8, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Rnd Seed", .min = 0, .max = 9999, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Rnd Lock", .min = 0, .max = 100, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Glide A", .min = 0, .max = 2000, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Glide B", .min = 0, .max = 2000, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Glide C", .min = 0, .max = 2000, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Glide D", .min = 0, .max = 2000, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Glide E", .min = 0, .max = 2000, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Glide F", .min = 0, .max = 2000, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Glide G", .min = 0, .max = 2000, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Glide H", .min = 0, .max = 2000, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Harmony", .min = 0, .max = 1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Deg B", .min = -14, .max = 14, .def = 2, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Deg C", .min = -14, .max = 14, .def = 4, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Deg D", .min = -14, .max = 14, .def = 6, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Deg E", .min = -14, .max = 14, .def = 7, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Deg F", .min = -14, .max = 14, .def = 9, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Deg G", .min = -14, .max = 14, .def = 11, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Deg H", .min = -14, .max = 14, .def = 14, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "BB Rate", .min = 1, .max = 480, .def = 80, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Morph", .min = 0, .max = 1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Scale B", .min = 0, .max = NUM_SCALES-1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = all_scale_names },
+    { .name = "Morph Amt", .min = 0, .max = 100, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Morph CV", .min = 0, .max = 28, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Note 1", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Note 2", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Note 3", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Note 4", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Note 5", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Note 6", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Note 7", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Note 8", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Note 9", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Note 10", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Note 11", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Note 12", .min = 0, .max = 1, .def = 1, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "Profile", .min = 0, .max = 1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "BB Out", .min = 0, .max = 28, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "BB LPF", .min = 0, .max = 1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+    { .name = "MIDI In", .min = 0, .max = 2, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "Note On", "Clocked"} },
+    { .name = "MIDI In Ch", .min = 0, .max = 16, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Detect", .min = 0, .max = 2, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "Show", "Apply"} },
+    { .name = "Clk B", .min = 0, .max = 28, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Clk C", .min = 0, .max = 28, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Clk D", .min = 0, .max = 28, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Clk E", .min = 0, .max = 28, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Clk F", .min = 0, .max = 28, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Clk G", .min = 0, .max = 28, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Clk H", .min = 0, .max = 28, .def = 0, .unit = kNT_unitNone, .scaling = 0, .enumStrings = NULL },
+    { .name = "Aud Quant", .min = 0, .max = 1, .def = 0, .unit = kNT_unitEnum, .scaling = 0, .enumStrings = (const char*[]){"Off", "On"} },
+};
+
+// --- Algorithm struct ---
+struct _copierAlgorithm : public _NT_algorithm {
+    CopierMaschineState* state;
+    _NT_parameter params[kNumParams]; // Per-instance copy, ranges follow the ASR capacity
 };
 
+// --- Scale lookup ---
+void load_scale(int scaleIdx, int* scale, int* scaleLen) {
+    if (scaleIdx < NUM_STANDARD_SCALES) {
+        get_standard_scale_intervals(scaleIdx, scale, scaleLen);
+    } else if (scaleIdx < NUM_STANDARD_SCALES + NUM_EXOTIC_SCALES) {
+        int exoticIdx = scaleIdx - NUM_STANDARD_SCALES;
+        for (int i = 0; i < SCALE_MAX_LEN; ++i) scale[i] = (int)exotic_scales[exoticIdx][i];
+        *scaleLen = SCALE_MAX_LEN;
+    } else {
+        for (int i = 0; i < SCALE_MAX_LEN; ++i) scale[i] = 0;
+        *scaleLen = 0;
+    }
+}
+
+// --- Note masks ---
+// Mask bit i enables degree i of the scale; scales with more than 12 degrees
+// reuse the bits from the start. MaskRot turns the mask across the degrees.
+#define NUM_NOTE_TOGGLES 12
+#define NOTE_MASK_ALL 0xFFF     // Every Note toggle on, the default
+
+// The mask the Note 1..12 toggles set
+inline int note_mask(const int16_t* v) {
+    int mask = 0;
+    for (int i = 0; i < NUM_NOTE_TOGGLES; ++i) mask |= (v[kParamNote1 + i] != 0) << i;
+    return mask;
+}
+inline bool degree_enabled(int mask, int maskRotate, int deg, int numDegrees) {
+    int i = (deg - maskRotate % numDegrees + numDegrees) % numDegrees;
+    return (mask >> (i % 12)) & 1;
+}
+
+// Semitones from pitch class pc (0..11) to the nearest one set in pcs, which
+// must not be empty. pcs is repeated one octave up, so the next set bit above
+// pc is a count of trailing zeros and the next one below pc + 12 a count of
+// leading zeros. Ties go down.
+inline int nearest_pc_delta(uint32_t pcs, int pc) {
+    uint32_t b = pcs | (pcs << 12);
+    int up = __builtin_ctz(b >> pc);
+    int down = __builtin_clz(b << (19 - pc));
+    return (up < down) ? up : -down;
+}
+
+// --- Quantizer table construction ---
+// Degree table of an octave scale from the pitch classes it contains
+void build_octave_degrees(QuantTable* table, const bool* present) {
+    int len = 0;
+    for (int pc = 0; pc < 12; ++pc) {
+        if (present[pc]) table->degrees[len++] = (float)pc;
+    }
+    table->numDegrees = len;
+    table->degrees[len] = table->degrees[0] + 12.0f;
+    table->degrees[len + 1] = INFINITY;
+}
+
+// Volts of each pitch class's note, from the semitone offsets
+void build_pc_volts(QuantTable* table) {
+    for (int pc = 0; pc < 12; ++pc) table->pcVolts[pc] = table->offset[pc + 11] / 12.0f;
+}
+
+// Degrees of a non-octave scale, scaled from twelfths of the period to semitones
+void build_period_degrees(QuantTable* table, int scaleIdx, int mask, int maskRotate) {
+    const float* row = exotic_scales[scaleIdx - NUM_STANDARD_SCALES];
+    float unit = table->period / 12.0f;
+    float all[SCALE_MAX_LEN];
+    int numAll = 1;
+    all[0] = 0.0f;
+    for (int i = 1; i < SCALE_MAX_LEN; ++i) {
+        float d = row[i] * unit;
+        if (d > all[numAll - 1] && d < table->period) all[numAll++] = d;
+    }
+    int len = 0;
+    for (int i = 0; i < numAll; ++i) {
+        if (degree_enabled(mask, maskRotate, i, numAll)) table->degrees[len++] = all[i];
+    }
+    if (len == 0) {
+        for (int i = 0; i < numAll; ++i) table->degrees[i] = all[i];
+        len = numAll;
+    }
+    table->numDegrees = len;
+    table->degrees[len] = table->degrees[0] + table->period;
+    table->degrees[len + 1] = INFINITY;
+
+    int i = 0;
+    for (int b = 0; b < PERIOD_MAX_BINS; ++b) {
+        float start = b * (1.0f / PERIOD_BINS_PER_SEMITONE);
+        while (i + 1 < len && table->degrees[i + 1] <= start) ++i;
+        table->bin[b] = (uint8_t)i;
+    }
+}
+
+// Pitch classes of an octave scale, one bit each; the root is always in
+uint32_t scale_pcs(int scaleIdx) {
+    int scale[SCALE_MAX_LEN];
+    int scaleLen = 0;
+    load_scale(scaleIdx, scale, &scaleLen);
+    uint32_t pcs = 1;
+    for (int i = 0; i < scaleLen; ++i) pcs |= 1u << (((scale[i] % 12) + 12) % 12);
+    return pcs;
+}
+
+// Octave table quantizing to the pitch classes set in active
+void build_octave_table(QuantTable* table, uint32_t active) {
+    table->period = 12.0f;
+    table->invPeriod = 1.0f / 12.0f;
+    table->periodic = false;
+
+    // n % 12 is negative below zero, so entries hold pc plus the distance to
+    // the nearest enabled note rather than a pitch class.
+    for (int pc = -11; pc <= 11; ++pc) {
+        table->offset[pc + 11] = (int8_t)(pc + nearest_pc_delta(active, (pc + 12) % 12));
+    }
+    build_pc_volts(table);
+
+    // Degree table for the harmonizer
+    bool present[12];
+    for (int pc = 0; pc < 12; ++pc) present[pc] = (active >> pc) & 1;
+    build_octave_degrees(table, present);
+}
+
+void build_quant_table(QuantTable* table, int scaleIdx, int mask, int maskRotate) {
+    if (scale_period(scaleIdx) != 12.0f) {
+        table->period = scale_period(scaleIdx);
+        table->invPeriod = 1.0f / table->period;
+        table->periodic = true;
+        build_period_degrees(table, scaleIdx, mask, maskRotate);
+        return;
+    }
+
+    // Pitch classes of the scale, then the ones the mask leaves enabled
+    uint32_t pcs = scale_pcs(scaleIdx);
+    int numDegrees = __builtin_popcount(pcs);
+    uint32_t active = 0;
+    int deg = 0;
+    for (int pc = 0; pc < 12; ++pc) {
+        if (!((pcs >> pc) & 1)) continue;
+        if (degree_enabled(mask, maskRotate, deg++, numDegrees)) active |= 1u << pc;
+    }
+    if (!active) active = pcs;
+    build_octave_table(table, active);
+}
+
+// --- Quantization function ---
+// Quantizes a note number, already shifted by root + transpose, to semitones.
+inline float quantize_note(const QuantTable* table, int n) {
+    if (!table->periodic) return (float)((n / 12) * 12 + table->offset[n % 12 + 11]);
+    float k = floorf(n * table->invPeriod);
+    float r = n - k * table->period;
+    if (r < 0.0f) { r += table->period; k -= 1.0f; }
+    else if (r >= table->period) { r -= table->period; k += 1.0f; }
+    int i = table->bin[(int)(r * PERIOD_BINS_PER_SEMITONE)];
+    while (r >= table->degrees[i + 1]) ++i;
+    float lo = table->degrees[i];
+    float hi = table->degrees[i + 1];
+    if (r < table->degrees[0]) {
+        // Masked root: the candidates straddle the period boundary
+        lo = table->degrees[table->numDegrees - 1] - table->period;
+        hi = table->degrees[0];
+    }
+    return k * table->period + ((hi - r < r - lo) ? hi : lo);
+}
+
+// Quantizes count voltages; offset is root + transpose in semitones. The
+// period check is made once per call. Octave scales then run a branch-free
+// loop without divides or library calls: the note is rounded half away from
+// zero by truncation, biased by whole octaves so it stays positive, folded
+// into octave and pitch class with a reciprocal multiply, and the pitch
+// class looks up its note in volts. Notes are clamped to +-QBATCH_RANGE so
+// no input can index outside the table.
+#define QBATCH_RANGE 12000.0f   // Semitones, 1000V
+#define QBATCH_BIAS 12288       // 1024 octaves
+void quantize_batch(const QuantTable* table, const float* __restrict in, float* __restrict out, int count, int offset) {
+    if (!table->periodic) {
+        const float* pcVolts = table->pcVolts;
+        int bias = offset + QBATCH_BIAS;
+        for (int i = 0; i < count; ++i) {
+            float x = in[i] * 12.0f;
+            x = (x > -QBATCH_RANGE) ? x : -QBATCH_RANGE;
+            x = (x < QBATCH_RANGE) ? x : QBATCH_RANGE;
+            int n = (int)(x + copysignf(0.49999997f, x)) + bias;
+            int octave = (int)((n + 0.5f) * (1.0f / 12.0f));
+            out[i] = (float)(octave - QBATCH_BIAS / 12) + pcVolts[n - octave * 12];
+        }
+        return;
+    }
+    for (int i = 0; i < count; ++i) {
+        out[i] = quantize_note(table, static_cast<int>(roundf(in[i] * 12.0f)) + offset) / 12.0f;
+    }
+}
+
+// --- Scale detection ---
+void init_detect(DetectState& det) {
+    for (int s = 0; s < NUM_SCALES; ++s) det.pcs[s] = (scale_period(s) == 12.0f) ? (uint16_t)scale_pcs(s) : 0;
+    det.sweepScore = -INFINITY;
+    det.sweepFit = -1;
+    det.fit.store(-1, std::memory_order_relaxed);
+    det.tableFit = -1;
+}
+
+// Adds a latched sample to the histogram and scores the next scales of the sweep
+void detect_edge(DetectState& det, float sample) {
+    int n = static_cast<int>(roundf(sample * 12.0f));
+    int pc = ((n % 12) + 12) % 12;
+    for (int i = 0; i < 12; ++i) det.hist[i] *= DETECT_DECAY;
+    det.hist[pc] += 1.0f;
+    det.total = det.total * DETECT_DECAY + 1.0f;
+
+    if (det.nextScale == 0) {
+        for (int i = 0; i < 12; ++i) det.snap[i] = det.snap[i + 12] = det.hist[i];
+        det.snapTotal = det.total;
+    }
+    for (int k = 0; k < DETECT_SCALES_PER_EDGE; ++k) {
+        uint32_t pcs = det.pcs[det.nextScale];
+        if (pcs) {
+            float share = __builtin_popcount(pcs) * (1.0f / 12.0f) * det.snapTotal;
+            for (int root = 0; root < 12; ++root) {
+                float in = 0.0f;
+                for (uint32_t b = pcs; b; b &= b - 1) in += det.snap[__builtin_ctz(b) + root];
+                if (in - share > det.sweepScore) {
+                    det.sweepScore = in - share;
+                    det.sweepFit = det.nextScale * 12 + root;
+                }
+            }
+        }
+        if (++det.nextScale == NUM_SCALES) {
+            det.fit.store(det.sweepFit, std::memory_order_relaxed);
+            det.nextScale = 0;
+            det.sweepScore = -INFINITY;
+            return; // The next sweep starts from a fresh snapshot
+        }
+    }
+}
+
+// Detect Apply's table: the fitted scale's pitch classes turned to its root
+void build_detect_table(QuantTable* table, int fit) {
+    uint32_t pcs = scale_pcs(fit / 12);
+    int root = fit % 12;
+    build_octave_table(table, ((pcs << root) | (pcs >> (12 - root))) & 0xFFFu);
+}
+
+// --- Quantizer table publishing ---
+// Picks the buffer of a double buffered handoff to fill: the pending one if
+// step() has not picked it up yet, otherwise the one step() stopped reading at
+// its last swap.
+inline QuantTable* claim_buffer(std::atomic<QuantTable*>& pending, const QuantTable* last, QuantTable* a, QuantTable* b) {
+    QuantTable* table = pending.exchange(nullptr, std::memory_order_acquire);
+    if (table) return table;
+    return (last == a) ? b : a;
+}
+
+// Called off the audio path
+void publish_quant_table(CopierMaschineState* state, int scaleIdx, int mask, int maskRotate) {
+    QuantTable* table = claim_buffer(state->pendingTable, state->lastPublished, &state->tables[0], &state->tables[1]);
+    build_quant_table(table, scaleIdx, mask, maskRotate);
+    state->lastPublished = table;
+    state->pendingTable.store(table, std::memory_order_release);
+}
+
+// --- Scale morphing ---
+// Each step moves every pitch class's nearest note from Scale towards Scale B,
+// so the morph position only picks a table. Scales with another period cannot
+// be blended with octave scales and switch over halfway instead.
+void build_morph_tables(QuantTable* tables, int scaleA, int scaleB, int mask, int maskRotate) {
+    QuantTable* a = &tables[0];
+    QuantTable* b = &tables[MORPH_STEPS - 1];
+    build_quant_table(a, scaleA, mask, maskRotate);
+    build_quant_table(b, scaleB, mask, maskRotate);
+    for (int m = 1; m < MORPH_STEPS - 1; ++m) {
+        QuantTable* t = &tables[m];
+        if (a->periodic || b->periodic) {
+            *t = (m < MORPH_STEPS / 2) ? *a : *b;
+            continue;
+        }
+        t->periodic = false;
+        t->period = 12.0f;
+        t->invPeriod = 1.0f / 12.0f;
+        bool present[12] = {};
+        for (int i = 0; i < QTABLE_SIZE; ++i) {
+            float d = (float)(b->offset[i] - a->offset[i]) * m / (MORPH_STEPS - 1);
+            t->offset[i] = (int8_t)(a->offset[i] + (int)roundf(d));
+            present[((t->offset[i] % 12) + 12) % 12] = true;
+        }
+        build_pc_volts(t);
+        build_octave_degrees(t, present);
+    }
+}
+
+// Called off the audio path, like publish_quant_table()
+void publish_morph_tables(CopierMaschineState* state, int scaleA, int scaleB, int mask, int maskRotate) {
+    QuantTable* tables = claim_buffer(state->pendingMorph, state->lastMorph, state->cold->morph[0], state->cold->morph[1]);
+    build_morph_tables(tables, scaleA, scaleB, mask, maskRotate);
+    state->lastMorph = tables;
+    state->pendingMorph.store(tables, std::memory_order_release);
+}
+
+// Called off the audio path, from draw() and when Detect changes: publishes
+// the table for the last finished sweep unless it is already out
+void publish_detect_table(CopierMaschineState* state) {
+    DetectState& det = state->cold->detect;
+    int fit = det.fit.load(std::memory_order_relaxed);
+    if (fit < 0 || fit == det.tableFit) return;
+    QuantTable* table = claim_buffer(state->pendingDetect, state->lastDetect, &state->cold->detectTables[0], &state->cold->detectTables[1]);
+    build_detect_table(table, fit);
+    det.tableFit = fit;
+    state->lastDetect = table;
+    state->pendingDetect.store(table, std::memory_order_release);
+}
+
+// --- Specifications ---
+enum {
+    kSpecCapacity,
+    kSpecAudio,         // 0=off, 1=Audio mode selectable
+    kNumSpecs
+};
+
+static const _NT_specification specifications[] = {
+    { .name = "ASR length", .min = ASR_MIN_SIZE, .max = ASR_MAX_SIZE, .def = ASR_DEFAULT_SIZE, .type = kNT_typeGeneric },
+    { .name = "Audio mode", .min = 0, .max = 1, .def = 0, .type = kNT_typeGeneric },
+};
+
+// --- ByteBeat rate ---
+void set_bytebeat_rate(CopierMaschineState* state, int rate) {
+    state->bbInc = ((uint64_t)(rate * BYTEBEAT_RATE_UNIT) << 32) / NT_globals.sampleRate;
+}
+
 // --- Algorithm requirements ---
-void calculateRequirements(_NT_algorithmRequirements& req, const int32_t*) {
+void calculateRequirements(_NT_algorithmRequirements& req, const int32_t* specifications) {
     req.numParameters = kNumParams;
     req.sram = sizeof(_copierAlgorithm);
-    req.dram = sizeof(CopierMaschineState);
-    req.dtc = 0;
+    req.dram = sizeof(CopierMaschineCold) + specifications[kSpecCapacity] * sizeof(float);
+    if (specifications[kSpecAudio]) req.dram += 2 * audio_ring_len(specifications[kSpecCapacity]) * sizeof(float);
+    req.dtc = sizeof(CopierMaschineState);
     req.itc = 0;
 }
 
 // --- Algorithm construction ---
-_NT_algorithm* construct(const _NT_algorithmMemoryPtrs& ptrs, const _NT_algorithmRequirements&, const int32_t*) {
+_NT_algorithm* construct(const _NT_algorithmMemoryPtrs& ptrs, const _NT_algorithmRequirements& req, const int32_t* specifications) {
     _copierAlgorithm* alg = reinterpret_cast<_copierAlgorithm*>(ptrs.sram);
-    alg->state = reinterpret_cast<CopierMaschineState*>(ptrs.dram);
-    memset(alg->state, 0, sizeof(CopierMaschineState));
-    alg->parameters = parameters;
+    int capacity = specifications[kSpecCapacity];
+    alg->state = reinterpret_cast<CopierMaschineState*>(ptrs.dtc);
+    memset((void*)alg->state, 0, sizeof(CopierMaschineState));
+    memset((void*)ptrs.dram, 0, req.dram);
+    alg->state->capacity = capacity;
+    alg->state->cold = reinterpret_cast<CopierMaschineCold*>(ptrs.dram);
+    alg->state->buffer = reinterpret_cast<float*>(ptrs.dram + sizeof(CopierMaschineCold));
+    alg->state->audioRing = specifications[kSpecAudio] ? alg->state->buffer + capacity : NULL;
+    alg->state->bufLen = parameters[kParamBufLen].def;
+    QuantTable* table = &alg->state->tables[0];
+    build_quant_table(table, parameters[kParamScale].def, NOTE_MASK_ALL, parameters[kParamMaskRotate].def);
+    alg->state->scaleTable = table;
+    alg->state->activeTable = table;
+    alg->state->lastPublished = table;
+    alg->state->pendingTable.store(nullptr, std::memory_order_relaxed);
+    build_morph_tables(alg->state->cold->morph[0], parameters[kParamScale].def, parameters[kParamScaleB].def, NOTE_MASK_ALL, parameters[kParamMaskRotate].def);
+    alg->state->morphTables = alg->state->cold->morph[0];
+    alg->state->lastMorph = alg->state->cold->morph[0];
+    alg->state->pendingMorph.store(nullptr, std::memory_order_relaxed);
+    init_detect(alg->state->cold->detect);
+    alg->state->detectTable = NULL;
+    alg->state->lastDetect = NULL;
+    alg->state->pendingDetect.store(nullptr, std::memory_order_relaxed);
+    for (int s = 0; s < NUM_STAGES; ++s) alg->state->midiOut.note[s] = -1;
+    alg->state->rnd.seed = -1;
+    alg->state->bbT = 0xFFFFFFFFu; // Forces evaluation at t = 0
+    set_bytebeat_rate(alg->state, parameters[kParamByteBeatRate].def);
+    alg->state->bbLpfCoef = 1.0f - expf(-6.2831853f * BYTEBEAT_LPF_HZ / NT_globals.sampleRate);
+    for (int s = 0; s < NUM_STAGES; ++s) alg->state->glideCoef[s] = 1.0f;
+    for (int s = 1; s < NUM_STAGES; ++s) alg->state->harmDegree[s] = (int8_t)parameters[kParamDegB + s - 1].def;
+    alg->state->tapsChanged.store(true, std::memory_order_relaxed);
+    memcpy(alg->params, parameters, sizeof(parameters));
+    alg->params[kParamBufIndex].max = capacity - 1;
+    alg->params[kParamBufLen].max = capacity;
+    if (!specifications[kSpecAudio]) alg->params[kParamMode].max = MODE_AUDIO - 1;
+    for (int s = 0; s < NUM_STAGES; ++s) alg->params[kParamTapA + s].max = capacity - 1;
+    alg->parameters = alg->params;
     alg->parameterPages = NULL;
     return alg;
 }
 
-// --- Quantization function ---
-float quantize(float v, int scaleIdx, int root, int transpose, int maskRotate) {
-    int scale[SCALE_MAX_LEN];
-    int scaleLen = 0;
-    if (scaleIdx < NUM_STANDARD_SCALES) {
-        get_standard_scale_intervals(scaleIdx, scale, &scaleLen);
-    } else if (scaleIdx < NUM_STANDARD_SCALES + NUM_EXOTIC_SCALES) {
-        int exoticIdx = scaleIdx - NUM_STANDARD_SCALES;
-        for (int i = 0; i < SCALE_MAX_LEN; ++i) scale[i] = (int)exotic_scales[exoticIdx][i];
-        scaleLen = SCALE_MAX_LEN;
+// --- Bus routing check ---
+// Outputs may legally be routed onto the buses step() reads from. Only CV In
+// is read frame by frame while outputs are written, so only it matters:
+// - clock buses are scanned CLOCK_SCAN_FRAMES ahead of any output write;
+// - Tap CV and Morph CV are read once, at block start;
+// - Random draws from its own generator and reads no bus;
+// - Audio mode reads each chunk of CV In before writing that chunk.
+void check_bus_alias(_copierAlgorithm* alg) {
+    bool alias = false;
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        if (alg->v[kParamOutputA + s] == alg->v[kParamInputCV]) alias = true;
+    }
+    alg->state->busesAlias.store(alias, std::memory_order_relaxed);
+}
+
+// --- Parameter change handler ---
+void parameterChanged(_NT_algorithm* self, int p) {
+    _copierAlgorithm* alg = (_copierAlgorithm*)self;
+    switch (p) {
+        case kParamInputCV:
+            check_bus_alias(alg);
+            break;
+        case kParamScale:
+        case kParamMaskRotate:
+            publish_quant_table(alg->state, alg->v[kParamScale], note_mask(alg->v), alg->v[kParamMaskRotate]);
+            publish_morph_tables(alg->state, alg->v[kParamScale], alg->v[kParamScaleB], note_mask(alg->v), alg->v[kParamMaskRotate]);
+            break;
+        case kParamProfile:
+            if (alg->v[kParamProfile]) alg->state->profileReset.store(true, std::memory_order_release);
+            break;
+        case kParamScaleB:
+            publish_morph_tables(alg->state, alg->v[kParamScale], alg->v[kParamScaleB], note_mask(alg->v), alg->v[kParamMaskRotate]);
+            break;
+        case kParamDetect:
+            if (alg->v[kParamDetect] == DETECT_APPLY) publish_detect_table(alg->state);
+            break;
+        case kParamByteBeatRate:
+            set_bytebeat_rate(alg->state, alg->v[kParamByteBeatRate]);
+            break;
+        case kParamHarmony:
+            alg->state->harmony = alg->v[kParamHarmony] != 0;
+            break;
+        case kParamBufIndex:
+        case kParamTapPattern:
+            alg->state->tapsChanged.store(true, std::memory_order_release);
+            break;
+        default:
+            if (p >= kParamTapA && p < kParamTapA + NUM_STAGES) {
+                alg->state->tapsChanged.store(true, std::memory_order_release);
+            } else if (p >= kParamDegB && p < kParamDegB + NUM_STAGES - 1) {
+                alg->state->harmDegree[p - kParamDegB + 1] = (int8_t)alg->v[p];
+            } else if (p >= kParamGlideA && p < kParamGlideA + NUM_STAGES) {
+                int ms = alg->v[p];
+                alg->state->glideCoef[p - kParamGlideA] = (ms > 0) ? 1.0f - expf(-1000.0f / (ms * (float)NT_globals.sampleRate)) : 1.0f;
+            } else if (p >= kParamOutputA && p < kParamOutputA + NUM_STAGES) {
+                check_bus_alias(alg);
+            } else if (p >= kParamNote1 && p < kParamNote1 + NUM_NOTE_TOGGLES) {
+                publish_quant_table(alg->state, alg->v[kParamScale], note_mask(alg->v), alg->v[kParamMaskRotate]);
+                publish_morph_tables(alg->state, alg->v[kParamScale], alg->v[kParamScaleB], note_mask(alg->v), alg->v[kParamMaskRotate]);
+            }
+            break;
+    }
+}
+
+// --- Random source ---
+inline uint32_t xorshift32(uint32_t& x) {
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+void random_seed(RandomState& rnd, int seed) {
+    rnd.rng = 0x9E3779B9u ^ ((uint32_t)seed * 0x85EBCA6Bu);
+    if (rnd.rng == 0) rnd.rng = 1;
+    rnd.seed = seed;
+}
+
+// Draws the value latched at a clock edge. With probability lock (0..100)
+// recycled, the value written BufLen edges ago that is about to be
+// overwritten, comes back, which loops the register like a Turing machine;
+// otherwise a new value in 0..5V (times gain) is drawn. Nothing is generated
+// between edges.
+float random_draw(uint32_t& rng, int lock, float gain, float recycled) {
+    uint32_t r = xorshift32(rng);
+    if ((int)(((r >> 24) * 100) >> 8) < lock) return recycled;
+    return (r & 0xFFFFFF) * (5.0f / 16777216.0f) * gain;
+}
+
+float random_step(CopierMaschineState* state, int lock, float gain, float recycled) {
+    state->rnd.value = random_draw(state->rnd.rng, lock, gain, recycled);
+    return state->rnd.value;
+}
+
+// --- Tap pattern engine ---
+void resolve_tap_offsets(CopierMaschineState* state, const int16_t* v, int scan) {
+    int pattern = v[kParamTapPattern];
+    int bufIdx = v[kParamBufIndex];
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        int off = (pattern == TAP_PATTERN_USER) ? v[kParamTapA + s] : bufIdx * tap_pattern_steps[pattern][s];
+        state->tapOffset[s] = (off + scan) % state->bufLen;
+    }
+    state->tapScan = scan;
+}
+
+// Absolute read slots; only needs redoing when the write head moves or the
+// offsets are resolved again.
+void resolve_tap_indices(CopierMaschineState* state) {
+    int newest = (state->writePos - 1 + state->bufLen) % state->bufLen;
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        int idx = newest - state->tapOffset[s];
+        if (idx < 0) idx += state->bufLen;
+        state->tapIdx[s] = (uint16_t)idx;
+    }
+}
+
+// --- Harmonizer ---
+// Stage A's note is located in the scale's degree table once; every other
+// stage adds its degree offset, carrying whole periods, and looks its note up.
+void harmonize(const CopierMaschineState* state, float note, float* dst) {
+    const QuantTable* table = state->activeTable;
+    int len = table->numDegrees;
+    int per = (int)floorf(note * table->invPeriod + 1e-3f);
+    float r = note - per * table->period;
+    int deg = 0;
+    if (table->degrees[0] - r > r - (table->degrees[len - 1] - table->period)) {
+        deg = len - 1; // Below a masked root, nearest to the previous period's top degree
+        --per;
     } else {
-        for (int i = 0; i < SCALE_MAX_LEN; ++i) scale[i] = 0;
-        scaleLen = 0;
+        while (deg < len && table->degrees[deg + 1] - r < r - table->degrees[deg]) ++deg;
+        if (deg == len) { deg = 0; ++per; }
     }
-    float note = v * 12.0f;
-    int n = static_cast<int>(roundf(note));
-    n += root + transpose;
-    int scaleDegree = 0;
-    int minDist = 128;
-    for (int i = 0; i < scaleLen; ++i) {
-        int deg = (scale[i] + maskRotate) % 12;
-        int dist = abs((n % 12) - deg);
-        if (dist < minDist) {
-            minDist = dist;
-            scaleDegree = i;
-        }
+    dst[0] = note / 12.0f;
+    for (int s = 1; s < NUM_STAGES; ++s) {
+        int d = deg + state->harmDegree[s];
+        int carry = (d >= 0) ? d / len : (d - len + 1) / len;
+        d -= carry * len;
+        dst[s] = ((per + carry) * table->period + table->degrees[d]) / 12.0f;
+    }
+}
+
+// --- Cascade ---
+// Puts the latched values of cascaded stages back over what their taps gave
+inline void overlay_cascade(CopierMaschineState* state) {
+    for (uint32_t m = state->cascade; m; m &= m - 1) {
+        int s = __builtin_ctz(m);
+        state->stageValue[s] = state->cascadeValue[s];
+    }
+}
+
+// --- Stage evaluation ---
+// Stage values for the source values under the taps
+inline void evaluate_stages(const CopierMaschineState* state, const float* tapped, int offset, float* dst) {
+    if (state->harmony) {
+        int n = static_cast<int>(roundf(tapped[0] * 12.0f)) + offset;
+        harmonize(state, quantize_note(state->activeTable, n), dst);
+    } else {
+        quantize_batch(state->activeTable, tapped, dst, NUM_STAGES, offset);
     }
-    int quantized = (n / 12) * 12 + scale[scaleDegree];
-    return quantized / 12.0f;
+}
+
+inline void record_stage_inputs(const CopierMaschineState* state, int offset, StageInputs& in) {
+    in.writePos = state->writePos;
+    in.bufLen = state->bufLen;
+    in.offset = offset;
+    in.table = state->activeTable;
+    in.harmony = state->harmony;
+    in.cascade = state->cascade;
+    memcpy(in.tapOffset, state->tapOffset, sizeof(in.tapOffset));
+    memcpy(in.harmDegree, state->harmDegree, sizeof(in.harmDegree));
+}
+
+inline bool stage_inputs_match(const CopierMaschineState* state, int offset, const StageInputs& in) {
+    return in.table == state->activeTable && in.writePos == state->writePos && in.bufLen == state->bufLen
+        && in.offset == offset && in.harmony == state->harmony && in.cascade == state->cascade
+        && !memcmp(in.tapOffset, state->tapOffset, sizeof(in.tapOffset))
+        && !memcmp(in.harmDegree, state->harmDegree, sizeof(in.harmDegree));
+}
+
+void refresh_stages(CopierMaschineState* state, int offset) {
+    float tapped[NUM_STAGES];
+    for (int s = 0; s < NUM_STAGES; ++s) tapped[s] = state->buffer[state->tapIdx[s]];
+    evaluate_stages(state, tapped, offset, state->stageValue);
+    overlay_cascade(state);
+    record_stage_inputs(state, offset, state->stageInputs);
 }
 
 // --- Integer Sequence stepping function ---
@@ -631,8 +1603,495 @@ int intseq_step(IntSeqState& state, int seqIdx, int start, int len, int stride,
     return value;
 }
 
+// --- Display dirty tracking ---
+// Flags the display column of a freshly written slot for draw()
+inline void mark_dirty(CopierMaschineState* state, int slot) {
+    if (slot >= state->bufLen) return;
+    int col = disp_column(slot, state->bufLen);
+    state->cold->dirtyCols[col >> 5].fetch_or(1u << (col & 31), std::memory_order_release);
+}
+
+// Stores the source value Track mode follows in the newest slot, flagging its
+// column when the value moved
+inline void store_tracked(CopierMaschineState* state, int head, float v) {
+    if (state->buffer[head] == v) return;
+    state->buffer[head] = v;
+    mark_dirty(state, head);
+}
+
+// --- Tracking quantizer ---
+// Hands the tracked note to the stages reading the newest slot. In harmony
+// mode only stage A reads a tap; the other stages follow it.
+void apply_track(CopierMaschineState* state, int head) {
+    if (state->harmony) {
+        if (state->tapIdx[0] == head) harmonize(state, state->trackNote, state->stageValue);
+    } else {
+        for (int s = 0; s < NUM_STAGES; ++s) {
+            if (state->tapIdx[s] == head) state->stageValue[s] = state->trackNote / 12.0f;
+        }
+    }
+    overlay_cascade(state);
+}
+
+// Requantizes the newest slot and caches the input range that maps to the
+// same note, so following the input only costs two compares per sample until
+// it leaves that range. hyst (volts) widens the range to stop chatter.
+void track_head(CopierMaschineState* state, int head, float v, int offset, float hyst) {
+    const QuantTable* table = state->activeTable;
+    state->buffer[head] = v;
+    int n = static_cast<int>(roundf(v * 12.0f));
+    float q = quantize_note(table, n + offset);
+    int lo = n, hi = n;
+    while (hi - n < table->period && quantize_note(table, hi + 1 + offset) == q) ++hi;
+    while (n - lo < table->period && quantize_note(table, lo - 1 + offset) == q) --lo;
+    state->binLo = (lo - 0.5f) * (1.0f / 12.0f) - hyst;
+    state->binHi = (hi + 0.5f) * (1.0f / 12.0f) + hyst;
+    state->trackNote = q;
+    state->trackTable = table;
+    state->trackOffset = offset;
+    mark_dirty(state, head);
+    apply_track(state, head);
+}
+
+inline void invalidate_track(CopierMaschineState* state) {
+    state->binLo = INFINITY;
+    state->binHi = -INFINITY;
+}
+
+// --- MIDI note output ---
+// Sends note off/on pairs for every enabled stage whose quantized pitch differs
+// from the note it is holding. Offs go out before ons so a batch never leaves
+// two notes overlapping on one channel. Channel 0 turns a stage's output off.
+void send_stage_notes(CopierMaschineState* state, const int16_t* v) {
+    MidiOutState& m = state->midiOut;
+    uint32_t dest = midi_dest_flags[v[kParamMidiDest]];
+    uint8_t vel = (uint8_t)v[kParamMidiVel];
+    int8_t on[NUM_STAGES];
+    int numOn = 0;
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        int ch = v[kParamMidiChA + s] - 1;
+        int note = -1;
+        if (ch >= 0) {
+            note = (int)roundf(state->stageValue[s] * 12.0f) + MIDI_NOTE_ZERO_V;
+            if (note < 0) note = 0;
+            if (note > 127) note = 127;
+        }
+        if (note == m.note[s] && ch == m.channel[s]) continue;
+        if (m.note[s] >= 0) {
+            NT_sendMidi3ByteMessage(dest, 0x80 | m.channel[s], m.note[s], 0);
+        }
+        m.note[s] = (int8_t)note;
+        m.channel[s] = (int8_t)ch;
+        if (note >= 0) on[numOn++] = (int8_t)s;
+    }
+    for (int i = 0; i < numOn; ++i) {
+        int s = on[i];
+        NT_sendMidi3ByteMessage(dest, 0x90 | m.channel[s], m.note[s], vel);
+    }
+}
+
+// --- Per-block constants and running values for the frame loop ---
+struct BlockParams {
+    const int16_t* v;
+    int offset;
+    bool hold;
+    float gain;
+    int cvSource;
+    int bbEqn, bbP0, bbP1, bbP2;
+    int intSeqIdx, intSeqMod, intSeqStart, intSeqLen, intSeqDir, intSeqStride;
+    int rndLock;
+    bool track;
+    float hyst;
+    bool midiOut;
+    bool midiClocked; // MIDI In replaces the source sample
+    bool detect;      // Latched samples feed scale detection
+    bool perFrame;    // The source or track mode needs every frame, not just edges
+    // Distinct clock buses, the main Clock first
+    const float* clock[NUM_STAGES];
+    int clockBus[NUM_STAGES];
+    int numClocks;
+    int8_t stageClock[NUM_STAGES]; // Clock of each cascaded stage, -1 = follows its tap
+    uint32_t cascadeBuses;         // Clocks driving some cascaded stage
+    int edges;      // Clock edges taken this block
+    int frame;      // Frame being processed
+    int head;       // Newest slot
+    float tracked;  // Newest source sample, stored back on edges and at block end
+};
+
+// --- ByteBeat rendering ---
+// The ByteBeat stream is rendered a chunk at a time into a buffer on the
+// stack and feeds both the ASR and BB Out. The equation only runs when the
+// integer time advances.
+#define BYTEBEAT_CHUNK CLOCK_SCAN_FRAMES // Frames rendered, then processed, at a time
+void render_bytebeat(CopierMaschineState* state, const BlockParams& bp, float* out, int numFrames) {
+    uint64_t phase = state->bbPhase;
+    uint64_t inc = state->bbInc;
+    uint32_t lastT = state->bbT;
+    float value = state->bbValue;
+    for (int i = 0; i < numFrames; ++i) {
+        uint32_t t = (uint32_t)(phase >> 32);
+        if (t != lastT) {
+            lastT = t;
+            value = bytebeat(bp.bbEqn, t, bp.bbP0, bp.bbP1, bp.bbP2);
+        }
+        out[i] = value;
+        phase += inc;
+    }
+    state->bbPhase = phase;
+    state->bbT = lastT;
+    state->bbValue = value;
+}
+
+// Copies the stream to BB Out, optionally through a one-pole lowpass that
+// takes the edge off the stepped waveform
+void write_bytebeat_out(CopierMaschineState* state, float* __restrict out, const float* __restrict bb, int numFrames, bool lpf) {
+    if (!lpf) {
+        memcpy(out, bb, numFrames * sizeof(float));
+        return;
+    }
+    float y = state->bbLpfOut;
+    float coef = state->bbLpfCoef;
+    for (int i = 0; i < numFrames; ++i) {
+        y += coef * (bb[i] - y);
+        out[i] = y;
+    }
+    state->bbLpfOut = y;
+}
+
+// --- MIDI input ---
+// Applies the note-ons queued since the last block at its first frame.
+// Nothing is written while the ASR is frozen: on Hold, and in Audio mode,
+// where notes only reach the ring through Clocked MIDI In. Returns true if
+// any were written into the ASR.
+bool drain_midi_in(CopierMaschineState* state, int mode, bool frozen) {
+    bool written = false;
+    uint8_t note;
+    while (midi_queue_pop(state->midiIn, note)) {
+        float v = (note - MIDI_NOTE_ZERO_V) / 12.0f;
+        state->midiValue = v;
+        if (mode == MIDI_IN_NOTE_ON && !frozen) {
+            state->buffer[state->writePos] = v;
+            mark_dirty(state, state->writePos);
+            state->writePos = (state->writePos + 1) % state->bufLen;
+            written = true;
+        }
+    }
+    if (written) {
+        resolve_tap_indices(state);
+        state->trackTable = NULL; // The tracked slot is no longer the newest
+        state->stageInputs.table = NULL; // Same writePos after a full lap
+    }
+    return written;
+}
+
+// --- Clock edge scan ---
+// One pass over [from, to) finds the rising edges (crossing 1V) of all the
+// block's clock buses, so events come out sorted by frame and the cost grows
+// with the number of distinct buses, not of stages. Returns the event count.
+int scan_clock_edges(CopierMaschineState* state, const BlockParams& bp, int from, int to, ClockEvent* events) {
+    float last[NUM_STAGES];
+    for (int j = 0; j < bp.numClocks; ++j) last[j] = state->lastClock[bp.clockBus[j]];
+    int count = 0;
+    for (int i = from; i < to; ++i) {
+        uint32_t buses = 0;
+        for (int j = 0; j < bp.numClocks; ++j) {
+            float c = bp.clock[j][i];
+            buses |= (uint32_t)(c > 1.0f && last[j] <= 1.0f) << j;
+            last[j] = c;
+        }
+        if (buses) {
+            events[count].frame = (uint16_t)i;
+            events[count].buses = (uint16_t)buses;
+            ++count;
+        }
+    }
+    for (int j = 0; j < bp.numClocks; ++j) state->lastClock[bp.clockBus[j]] = last[j];
+    return count;
+}
+
+// Stages with their own clock copy their predecessor on its edges, like a
+// chain of sample-and-holds. Going from the last stage down, every stage
+// clocked at a frame takes what its predecessor held before that frame.
+void latch_cascade(CopierMaschineState* state, const BlockParams& bp, uint32_t buses) {
+    for (int s = NUM_STAGES - 1; s > 0; --s) {
+        if (bp.stageClock[s] >= 0 && ((buses >> bp.stageClock[s]) & 1)) {
+            state->cascadeValue[s] = state->stageValue[s - 1];
+            state->stageValue[s] = state->cascadeValue[s];
+        }
+    }
+}
+
+// --- Clock look-ahead ---
+// The main clock's period is tracked in frames. A block without edges that
+// expects the next one during the following block evaluates the stages as
+// that edge will leave them, so the edge only has to commit them. Taps on
+// older slots read what is already there. The newest slot is only predicted
+// for Random, drawn ahead on a copy of the generator, and for clocked MIDI
+// In; with any other source no stage may read it. The edge checks the values
+// still hold and refreshes as before when they do not. Track mode rewrites the
+// newest slot between edges and never looks ahead.
+void look_ahead(CopierMaschineState* state, const BlockParams& bp) {
+    Lookahead& la = state->ahead;
+    int slot = state->writePos; // Slot the edge writes, the newest after it
+    int idx[NUM_STAGES];
+    float tapped[NUM_STAGES];
+    la.needsSample = false;
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        idx[s] = slot - state->tapOffset[s];
+        if (idx[s] < 0) idx[s] += state->bufLen;
+        if (idx[s] == slot) la.needsSample = true;
+        tapped[s] = state->buffer[idx[s]];
+    }
+    if (la.needsSample) {
+        if (bp.midiClocked) {
+            la.sample = state->midiValue;
+        } else if (bp.cvSource == 3) {
+            uint32_t rng = state->rnd.rng;
+            la.sample = random_draw(rng, bp.rndLock, bp.gain, state->buffer[state->writePos]);
+        } else {
+            return;
+        }
+        for (int s = 0; s < NUM_STAGES; ++s) {
+            if (idx[s] == slot) tapped[s] = la.sample;
+        }
+    }
+    evaluate_stages(state, tapped, bp.offset, la.value);
+    record_stage_inputs(state, bp.offset, la.inputs);
+    la.valid = true;
+}
+
+// True if the look-ahead values are what an edge latching sample produces.
+// Never in Track mode: the edge writes the tracked value into the head slot
+// first, which the look-ahead did not see.
+inline bool look_ahead_holds(const CopierMaschineState* state, const BlockParams& bp, float sample) {
+    const Lookahead& la = state->ahead;
+    return la.valid && !bp.track && (!la.needsSample || la.sample == sample) && stage_inputs_match(state, bp.offset, la.inputs);
+}
+
+// --- Per-frame processing ---
+// Returns true if the stage values may have changed at this frame. buses
+// holds the clock edges found at it by scan_clock_edges().
+inline bool process_frame(CopierMaschineState* state, BlockParams& bp, float cvIn, uint32_t buses) {
+    bool changed = false;
+    bool clk = buses & 1;
+
+    float sample = 0.0f;
+    if (bp.cvSource == 0) {
+        sample = cvIn * bp.gain;
+    } else if (bp.cvSource == 1) {
+        sample = cvIn; // Rendered by render_bytebeat() for the whole block
+    } else if (bp.cvSource == 2) {
+        int val = intseq_step(state->intseq, bp.intSeqIdx, bp.intSeqStart, bp.intSeqLen, bp.intSeqStride, bp.intSeqDir);
+        sample = (val % bp.intSeqMod) / 12.0f;
+    } else if (bp.cvSource == 3) {
+        sample = (clk && !bp.hold) ? random_step(state, bp.rndLock, bp.gain, state->buffer[state->writePos]) : state->rnd.value;
+    }
+    if (bp.midiClocked) sample = state->midiValue;
+
+    if ((buses & bp.cascadeBuses) && !bp.hold) {
+        latch_cascade(state, bp, buses);
+        if (bp.midiOut && !clk) send_stage_notes(state, bp.v);
+        changed = true;
+    }
+
+    if (clk) {
+        uint32_t now = state->frameCount + bp.frame;
+        state->ahead.period = now - state->ahead.lastEdge;
+        state->ahead.lastEdge = now;
+    }
+
+    if (clk && !bp.hold) {
+        bool ahead = look_ahead_holds(state, bp, sample);
+        state->ahead.valid = false;
+        if (bp.track) store_tracked(state, bp.head, bp.tracked);
+        state->buffer[state->writePos] = sample;
+        mark_dirty(state, state->writePos);
+        state->writePos = (state->writePos + 1) % state->bufLen;
+        if (bp.detect) detect_edge(state->cold->detect, sample);
+        resolve_tap_indices(state);
+        if (ahead) {
+            memcpy(state->stageValue, state->ahead.value, sizeof(state->stageValue));
+            overlay_cascade(state);
+            record_stage_inputs(state, bp.offset, state->stageInputs);
+        } else {
+            refresh_stages(state, bp.offset);
+        }
+        bp.head = (state->writePos - 1 + state->bufLen) % state->bufLen;
+        invalidate_track(state);
+        if (bp.midiOut) send_stage_notes(state, bp.v);
+        bp.edges++;
+        changed = true;
+    }
+
+    if (bp.track) {
+        bp.tracked = sample;
+        if (sample < state->binLo || sample >= state->binHi) {
+            track_head(state, bp.head, sample, bp.offset, bp.hyst);
+            if (bp.midiOut) send_stage_notes(state, bp.v);
+            changed = true;
+        }
+    }
+    return changed;
+}
+
+// --- Output runs ---
+inline void fill_run(float* __restrict dst, float value, int from, int to) {
+    for (int i = from; i < to; ++i) dst[i] = value;
+}
+
+// --- Glide ---
+#define GLIDE_SETTLE 1e-6f // Volts; closer than this a glide snaps to its target
+
+// One-pole glide of all stages towards target over [from, to). The lanes are
+// independent, so the inner loop maps onto SIMD where the target has it.
+void glide_run(CopierMaschineState* state, float* const* out, const float* target, int from, int to) {
+    float y[NUM_STAGES];
+    float c[NUM_STAGES];
+    memcpy(y, state->glideOut, sizeof(y));
+    memcpy(c, state->glideCoef, sizeof(c));
+    for (int i = from; i < to; ++i) {
+        for (int s = 0; s < NUM_STAGES; ++s) {
+            y[s] += c[s] * (target[s] - y[s]);
+        }
+        for (int s = 0; s < NUM_STAGES; ++s) {
+            out[s][i] = y[s];
+        }
+    }
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        if (fabsf(target[s] - y[s]) < GLIDE_SETTLE) y[s] = target[s];
+    }
+    memcpy(state->glideOut, y, sizeof(y));
+}
+
+// Writes a run of constant stage targets. The glide filters only run while
+// some stage with a glide time has not reached its target.
+inline void write_run(CopierMaschineState* state, float* const* out, const float* target, int from, int to) {
+    bool gliding = false;
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        if (state->glideCoef[s] < 1.0f && state->glideOut[s] != target[s]) gliding = true;
+        else state->glideOut[s] = target[s];
+    }
+    if (gliding) {
+        glide_run(state, out, target, from, to);
+    } else {
+        for (int s = 0; s < NUM_STAGES; ++s) fill_run(out[s], target[s], from, to);
+    }
+}
+
+// --- Block processing ---
+// Clock buses are scanned CLOCK_SCAN_FRAMES at a time before any of those
+// frames' outputs are written.
+
+// Outputs may share a bus with CV In: every frame is read before its outputs
+// are written, as the input would otherwise be overwritten.
+void process_block_aliased(CopierMaschineState* state, BlockParams& bp, const float* inCV, float* const* out, int numFrames) {
+    ClockEvent events[CLOCK_SCAN_FRAMES];
+    for (int from = 0; from < numFrames; from += CLOCK_SCAN_FRAMES) {
+        int to = (from + CLOCK_SCAN_FRAMES < numFrames) ? from + CLOCK_SCAN_FRAMES : numFrames;
+        int numEvents = scan_clock_edges(state, bp, from, to, events);
+        for (int i = from, e = 0; i < to; ++i) {
+            uint32_t buses = (e < numEvents && events[e].frame == i) ? events[e++].buses : 0;
+            bp.frame = i;
+            process_frame(state, bp, inCV[i], buses);
+            write_run(state, out, state->stageValue, i, i + 1);
+        }
+    }
+}
+
+// Outputs are known not to alias the inputs: stage values are constant in
+// runs between the frames where they change, so each run is written after
+// it has been scanned with plain vectorizable stores. Unless something has
+// to follow every frame, only the frames carrying edges are visited.
+void process_block(CopierMaschineState* state, BlockParams& bp, const float* __restrict inCV, float* const* out, int numFrames) {
+    float held[NUM_STAGES];
+    memcpy(held, state->stageValue, sizeof(held));
+    int runStart = 0;
+    ClockEvent events[CLOCK_SCAN_FRAMES];
+    for (int from = 0; from < numFrames; from += CLOCK_SCAN_FRAMES) {
+        int to = (from + CLOCK_SCAN_FRAMES < numFrames) ? from + CLOCK_SCAN_FRAMES : numFrames;
+        int numEvents = scan_clock_edges(state, bp, from, to, events);
+        for (int i = from, e = 0; i < to; ++i) {
+            if (!bp.perFrame) {
+                if (e == numEvents) break;
+                i = events[e].frame;
+            }
+            uint32_t buses = (e < numEvents && events[e].frame == i) ? events[e++].buses : 0;
+            bp.frame = i;
+            if (process_frame(state, bp, inCV[i], buses)) {
+                write_run(state, out, held, runStart, i);
+                memcpy(held, state->stageValue, sizeof(held));
+                runStart = i;
+            }
+        }
+    }
+    write_run(state, out, held, runStart, numFrames);
+}
+
+// --- Audio-rate processing ---
+// Each tap becomes a delay of its offset in samples. A chunk of source samples
+// is written before the taps read it; the ring's AUDIO_CHUNK spare slots keep
+// the longest delay from being overwritten first. Hold recycles the sample
+// BufLen back, which loops the last BufLen samples. Glide, harmony, cascade
+// and MIDI follow clock edges and are bypassed.
+
+// The sample BufLen back from dst, which points into the ring; its first copy
+// holds everything written before, dst[0..i) included
+inline float audio_recycled(const CopierMaschineState* state, const float* dst, int i) {
+    int j = (int)(dst - state->audioRing) - state->bufLen + i;
+    if (j < 0) j += audio_ring_len(state->capacity);
+    return state->audioRing[j];
+}
+
+// Source samples for one chunk
+void audio_source(CopierMaschineState* state, const BlockParams& bp, const float* inCV, float* dst, int n) {
+    if (bp.midiClocked) {
+        for (int i = 0; i < n; ++i) dst[i] = state->midiValue;
+    } else if (bp.cvSource == 0) {
+        for (int i = 0; i < n; ++i) dst[i] = inCV[i] * bp.gain;
+    } else if (bp.cvSource == 1) {
+        memcpy(dst, inCV, n * sizeof(float));
+    } else if (bp.cvSource == 2) {
+        for (int i = 0; i < n; ++i) {
+            int val = intseq_step(state->intseq, bp.intSeqIdx, bp.intSeqStart, bp.intSeqLen, bp.intSeqStride, bp.intSeqDir);
+            dst[i] = (val % bp.intSeqMod) / 12.0f;
+        }
+    } else {
+        for (int i = 0; i < n; ++i) dst[i] = random_step(state, bp.rndLock, bp.gain, audio_recycled(state, dst, i));
+    }
+}
+
+void process_audio_block(CopierMaschineState* state, const BlockParams& bp, const float* inCV, float* const* out, int numFrames, bool quantize) {
+    int len = audio_ring_len(state->capacity);
+    float* ring = state->audioRing;
+    for (int from = 0; from < numFrames; from += AUDIO_CHUNK) {
+        int n = (numFrames - from < AUDIO_CHUNK) ? numFrames - from : AUDIO_CHUNK;
+        int w = state->audioPos;
+        // Written in place from w; what runs past the first copy belongs at
+        // the start of the ring, the rest is mirrored into the second
+        if (bp.hold) {
+            for (int i = 0; i < n; ++i) ring[w + i] = audio_recycled(state, ring + w, i);
+        } else {
+            audio_source(state, bp, inCV + from, ring + w, n);
+        }
+        int first = (w + n <= len) ? n : len - w;
+        memcpy(ring + len + w, ring + w, first * sizeof(float));
+        if (first < n) memcpy(ring, ring + len, (n - first) * sizeof(float));
+        for (int s = 0; s < NUM_STAGES; ++s) {
+            int start = w - state->tapOffset[s];
+            if (start < 0) start += len;
+            if (quantize) {
+                quantize_batch(state->activeTable, ring + start, out[s] + from, n, bp.offset);
+            } else {
+                memcpy(out[s] + from, ring + start, n * sizeof(float));
+            }
+        }
+        state->audioPos = (w + n) % len;
+    }
+}
+
 // --- Main processing loop ---
 void step(_NT_algorithm* self, float* busFrames, int numFramesBy4) {
+    uint32_t startCycles = NT_getCpuCycleCount();
     _copierAlgorithm* alg = (_copierAlgorithm*)self;
     CopierMaschineState* state = alg->state;
     int numFrames = numFramesBy4 * 4;
@@ -641,85 +2100,459 @@ void step(_NT_algorithm* self, float* busFrames, int numFramesBy4) {
     int clock_idx = alg->v[kParamClock] - 1;
 
     float* inCV = busFrames + inCV_idx * numFrames;
-    float* clock = busFrames + clock_idx * numFrames;
 
-    // Output buffer pointers for 8 stages
+    // Output buffer pointers for all stages
     float* out[NUM_STAGES];
     for (int s = 0; s < NUM_STAGES; ++s) {
         int out_idx = alg->v[kParamOutputA + s] - 1;
         out[s] = busFrames + out_idx * numFrames;
     }
 
-    int scale = alg->v[kParamScale];
-    int root = alg->v[kParamRoot];
-    int transpose = alg->v[kParamTranspose];
-    int maskRotate = alg->v[kParamMaskRotate];
-    int bufIdx = alg->v[kParamBufIndex];
+    // Pick up tables published by parameterChanged() or draw() since the last block. A
+    // table or morph buffer comes back holding another setting, so the
+    // tracked note, look-ahead and stage inputs are dropped on every swap.
+    QuantTable* table = state->pendingTable.exchange(nullptr, std::memory_order_acquire);
+    if (table) {
+        state->scaleTable = table;
+        state->trackTable = NULL;
+        state->ahead.valid = false;
+        state->stageInputs.table = NULL;
+    }
+    QuantTable* morph = state->pendingMorph.exchange(nullptr, std::memory_order_acquire);
+    if (morph) {
+        state->morphTables = morph;
+        state->trackTable = NULL;
+        state->ahead.valid = false;
+        state->stageInputs.table = NULL;
+    }
+    QuantTable* detect = state->pendingDetect.exchange(nullptr, std::memory_order_acquire);
+    if (detect) {
+        state->detectTable = detect;
+        state->trackTable = NULL;
+        state->ahead.valid = false;
+        state->stageInputs.table = NULL;
+    }
+
+    // Morph Amt plus Morph CV, 5V spanning the whole morph, picks a table
+    state->activeTable = state->scaleTable;
+    if (alg->v[kParamMorph]) {
+        float pos = alg->v[kParamMorphAmt] * 0.01f;
+        int morphCV_idx = alg->v[kParamMorphCV] - 1;
+        if (morphCV_idx >= 0) pos += busFrames[morphCV_idx * numFrames] * 0.2f;
+        int m = (int)(pos * (MORPH_STEPS - 1) + 0.5f);
+        if (m < 0) m = 0;
+        if (m > MORPH_STEPS - 1) m = MORPH_STEPS - 1;
+        state->activeTable = &state->morphTables[m];
+    }
+
+    int offset = alg->v[kParamRoot] + alg->v[kParamTranspose];
+
+    // Detect Apply quantizes to the last published fit, its root built into
+    // the table
+    if (alg->v[kParamDetect] == DETECT_APPLY && state->detectTable) {
+        state->activeTable = state->detectTable;
+        offset = alg->v[kParamTranspose];
+    }
+
     int bufLen = alg->v[kParamBufLen];
     if (bufLen < 4) bufLen = 4;
-    if (bufLen > ASR_BUF_SIZE) bufLen = ASR_BUF_SIZE;
+    if (bufLen > state->capacity) bufLen = state->capacity;
+    bool lenChanged = bufLen != state->bufLen;
     state->bufLen = bufLen;
-    bool hold = alg->v[kParamHold] != 0;
-    float gain = alg->v[kParamGain] * 0.01f;
-    int cvSource = alg->v[kParamCVSource];
-    int bbEqn = alg->v[kParamByteBeatEqn];
-    int bbP0 = alg->v[kParamByteBeatP0];
-    int bbP1 = alg->v[kParamByteBeatP1];
-    int bbP2 = alg->v[kParamByteBeatP2];
-
-    int intSeqIdx = alg->v[kParamIntSeq];
-    int intSeqMod = alg->v[kParamIntSeqMod];
-    int intSeqStart = alg->v[kParamIntSeqStart];
-    int intSeqLen = alg->v[kParamIntSeqLen];
-    int intSeqDir = alg->v[kParamIntSeqDir];
-    int intSeqStride = alg->v[kParamIntSeqStride];
+    if (state->writePos >= bufLen) state->writePos = 0; // Wraps as if the head had run off the end
+
+    // Tap CV scans all taps further back, 10V spanning the whole buffer
+    int scan = 0;
+    int tapCV_idx = alg->v[kParamTapCV] - 1;
+    if (tapCV_idx >= 0) {
+        scan = (int)(busFrames[tapCV_idx * numFrames] * 0.1f * bufLen);
+        if (scan < 0) scan = 0;
+        if (scan > bufLen - 1) scan = bufLen - 1;
+    }
+    if (state->tapsChanged.exchange(false, std::memory_order_acquire) || lenChanged || scan != state->tapScan) {
+        resolve_tap_offsets(state, alg->v, scan);
+        resolve_tap_indices(state);
+    }
+    BlockParams bp;
+    bp.v = alg->v;
+    bp.offset = offset;
+    bp.hold = alg->v[kParamHold] != 0;
+    bp.gain = alg->v[kParamGain] * 0.01f;
+    bp.cvSource = alg->v[kParamCVSource];
+    bp.bbEqn = alg->v[kParamByteBeatEqn];
+    bp.bbP0 = alg->v[kParamByteBeatP0];
+    bp.bbP1 = alg->v[kParamByteBeatP1];
+    bp.bbP2 = alg->v[kParamByteBeatP2];
+
+    bp.intSeqIdx = alg->v[kParamIntSeq];
+    bp.intSeqMod = alg->v[kParamIntSeqMod];
+    bp.intSeqStart = alg->v[kParamIntSeqStart];
+    bp.intSeqLen = alg->v[kParamIntSeqLen];
+    bp.intSeqDir = alg->v[kParamIntSeqDir];
+    bp.intSeqStride = alg->v[kParamIntSeqStride];
+    bp.rndLock = alg->v[kParamRndLock];
 
     // Initialize IntSeq state if needed
-    if (cvSource == 2) {
+    if (bp.cvSource == 2) {
         if (state->intseq.dir == 0) state->intseq.dir = 1;
-        if (state->intseq.pos < 0 || state->intseq.pos >= intSeqLen) state->intseq.pos = 0;
+        if (state->intseq.pos < 0 || state->intseq.pos >= bp.intSeqLen) state->intseq.pos = 0;
     }
 
-    for (int i = 0; i < numFrames; ++i) {
-        bool clk = (clock[i] > 1.0f && state->lastClock <= 1.0f);
-        state->lastClock = clock[i];
+    // Reseed when Rnd Seed changes so a seed always recalls the same sequence
+    if (bp.cvSource == 3 && state->rnd.seed != alg->v[kParamRndSeed]) {
+        random_seed(state->rnd, alg->v[kParamRndSeed]);
+    }
+
+    bp.midiClocked = alg->v[kParamMidiIn] == MIDI_IN_CLOCKED;
+    bp.detect = alg->v[kParamDetect] != DETECT_OFF;
+
+    // Clock buses: the main Clock, then every distinct stage clock. Stages
+    // joining the cascade hold what they were putting out.
+    bp.clock[0] = busFrames + clock_idx * numFrames;
+    bp.clockBus[0] = clock_idx;
+    bp.numClocks = 1;
+    bp.stageClock[0] = -1;
+    bp.cascadeBuses = 0;
+    uint32_t cascade = 0;
+    for (int s = 1; s < NUM_STAGES; ++s) {
+        bp.stageClock[s] = -1;
+        int bus = alg->v[kParamClkB + s - 1] - 1;
+        if (bus < 0) continue;
+        int j = 0;
+        while (j < bp.numClocks && bp.clockBus[j] != bus) ++j;
+        if (j == bp.numClocks) {
+            bp.clock[j] = busFrames + bus * numFrames;
+            bp.clockBus[j] = bus;
+            bp.numClocks++;
+        }
+        bp.stageClock[s] = (int8_t)j;
+        bp.cascadeBuses |= 1u << j;
+        cascade |= 1u << s;
+        if (!((state->cascade >> s) & 1)) state->cascadeValue[s] = state->stageValue[s];
+    }
+    state->cascade = cascade;
+
+    bool audio = alg->v[kParamMode] == MODE_AUDIO && state->audioRing;
+    bool midiWritten = drain_midi_in(state, alg->v[kParamMidiIn], bp.hold || audio);
+
+    // Stage values are only worked out again when something they came from
+    // changed. Track mode rewrites them and the newest slot between edges, so
+    // it refreshes every block and leaves nothing recorded.
+    bp.track = alg->v[kParamMode] == 1 && !bp.hold;
+    if (bp.track || !stage_inputs_match(state, offset, state->stageInputs)) refresh_stages(state, offset);
+
+    // Track mode: the newest slot follows the source between clock edges. The
+    // note it held in the last block stays valid unless the table or offset
+    // changed, which keeps the hysteresis working across blocks.
+    bp.hyst = alg->v[kParamHyst] * (1.0f / 1200.0f);
+    bp.perFrame = bp.track || bp.cvSource == 2; // IntSeq steps every frame
+    bp.head = (state->writePos - 1 + state->bufLen) % state->bufLen;
+    bp.tracked = state->buffer[bp.head];
+    if (bp.track) {
+        if (state->trackTable != state->activeTable || state->trackOffset != offset) {
+            invalidate_track(state);
+        } else {
+            apply_track(state, bp.head);
+        }
+    }
 
-        float sample = 0.0f;
-        if (cvSource == 0) {
-            sample = inCV[i] * gain;
-        } else if (cvSource == 1) {
-            sample = bytebeat(bbEqn, state->t++, bbP0, bbP1, bbP2);
-        } else if (cvSource == 2) {
-            int val = intseq_step(state->intseq, intSeqIdx, intSeqStart, intSeqLen, intSeqStride, intSeqDir);
-            sample = (val % intSeqMod) / 12.0f;
+    // Notes only change on clock edges; at block start just release notes of
+    // stages whose channel was changed or switched off.
+    bp.midiOut = false;
+    bp.edges = 0;
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        int ch = alg->v[kParamMidiChA + s] - 1;
+        if (ch >= 0) bp.midiOut = true;
+        if (state->midiOut.note[s] >= 0 && ch != state->midiOut.channel[s]) {
+            NT_sendMidi3ByteMessage(midi_dest_flags[alg->v[kParamMidiDest]], 0x80 | state->midiOut.channel[s], state->midiOut.note[s], 0);
+            state->midiOut.note[s] = -1;
         }
+    }
+    if (midiWritten && bp.midiOut) send_stage_notes(state, alg->v);
 
-        if (clk && !hold) {
-            state->buffer[state->writePos] = sample;
-            state->writePos = (state->writePos + 1) % state->bufLen;
+    // Clocks are ignored in Audio mode, but their levels stay current for
+    // edge detection after a switch back; read before any output is written
+    if (audio) {
+        for (int j = 0; j < bp.numClocks; ++j) state->lastClock[bp.clockBus[j]] = bp.clock[j][numFrames - 1];
+    }
+
+    // The block is processed BYTEBEAT_CHUNK frames at a time. ByteBeat goes
+    // into a buffer on the stack, which no bus aliases, and stands in for CV
+    // In when it is the source. Each chunk's BB Out is written after the chunk
+    // is processed, so it may share a bus with the inputs.
+    int bbOut_idx = alg->v[kParamBBOut] - 1;
+    float* bbOut = (bbOut_idx >= 0) ? busFrames + bbOut_idx * numFrames : NULL;
+    bool renderBB = bp.cvSource == 1 || bbOut;
+    bool aliased = state->busesAlias.load(std::memory_order_relaxed);
+    const float* clock[NUM_STAGES];
+    memcpy(clock, bp.clock, sizeof(clock));
+    for (int from = 0; from < numFrames; from += BYTEBEAT_CHUNK) {
+        int n = (numFrames - from < BYTEBEAT_CHUNK) ? numFrames - from : BYTEBEAT_CHUNK;
+        float bb[BYTEBEAT_CHUNK];
+        const float* src = inCV + from;
+        if (renderBB) {
+            render_bytebeat(state, bp, bb, n);
+            if (bp.cvSource == 1) src = bb;
+        }
+        float* chunkOut[NUM_STAGES];
+        for (int s = 0; s < NUM_STAGES; ++s) chunkOut[s] = out[s] + from;
+        for (int j = 0; j < bp.numClocks; ++j) bp.clock[j] = clock[j] + from;
+
+        if (audio) {
+            process_audio_block(state, bp, src, chunkOut, n, alg->v[kParamAudioQuant] != 0);
+        } else if (aliased) {
+            process_block_aliased(state, bp, src, chunkOut, n);
+        } else {
+            process_block(state, bp, src, chunkOut, n);
         }
 
-        int base = state->writePos;
-        for (int s = 0; s < NUM_STAGES; ++s) {
-            int idx = (base - 1 - bufIdx * (s + 1) + state->bufLen) % state->bufLen;
-            float q = quantize(state->buffer[idx], scale, root, transpose, maskRotate);
-            out[s][i] = q;
+        if (bbOut) write_bytebeat_out(state, bbOut + from, bb, n, alg->v[kParamBBLpf] != 0);
+        state->frameCount += n;
+    }
+
+    if (bp.track) {
+        store_tracked(state, bp.head, bp.tracked);
+        state->stageInputs.table = NULL;
+    }
+
+    // Look ahead in a block without edges when the next one is due during the
+    // following block, assuming it has as many frames as this one
+    if (bp.track || audio) {
+        state->ahead.valid = false;
+    } else if (bp.edges == 0 && !bp.hold && !state->ahead.valid && state->ahead.period > 0) {
+        int32_t due = (int32_t)(state->ahead.lastEdge + state->ahead.period - state->frameCount);
+        if (due < numFrames) look_ahead(state, bp);
+    }
+
+    // Profile: keep the slowest block and what it was doing
+    if (alg->v[kParamProfile]) {
+        if (state->profileReset.exchange(false, std::memory_order_acquire)) state->maxCycles = 0;
+        uint32_t cycles = NT_getCpuCycleCount() - startCycles;
+        StepProfile& p = state->cold->profile;
+        if (cycles > state->maxCycles) {
+            state->maxCycles = cycles;
+            p.cycles = cycles;
+            p.frames = numFrames;
+            p.edges = bp.edges;
+            p.scale = alg->v[kParamScale];
+            p.cvSource = bp.cvSource;
+            p.bufLen = bufLen;
+            p.mode = alg->v[kParamMode];
         }
     }
 }
 
+// --- MIDI message handler ---
+// Runs outside the audio path: note-ons on the MIDI In channel are queued for
+// step(). Velocity 0 is a note-off.
+void midiMessage(_NT_algorithm* self, uint8_t byte0, uint8_t byte1, uint8_t byte2) {
+    _copierAlgorithm* alg = (_copierAlgorithm*)self;
+    if (alg->v[kParamMidiIn] == MIDI_IN_OFF) return;
+    if ((byte0 & 0xF0) != 0x90 || byte2 == 0) return;
+    int ch = alg->v[kParamMidiInCh];
+    if (ch != 0 && (byte0 & 0x0F) != ch - 1) return;
+    midi_queue_push(alg->state->midiIn, byte1);
+}
+
+static const char* root_names[12] = {
+    "C", "C#", "D", "D#", "E", "F", "F#", "G", "G#", "A", "A#", "B"
+};
+
+// Redraws one column, returns the number of primitives issued. A shared
+// column shows its last slot, or the newest slot while the head is in it.
+int draw_column(const CopierMaschineState* state, int col, int newest) {
+    int bufLen = state->bufLen;
+    int slot = col;
+    if (bufLen > DISP_COLS) {
+        slot = ((col + 1) * bufLen + DISP_COLS - 1) / DISP_COLS - 1;
+        if (disp_column(newest, bufLen) == col) slot = newest;
+    }
+    int x0 = col * DISP_COL_W;
+    int x1 = x0 + DISP_COL_W - 2;
+    NT_drawShapeI(kNT_rectangle, x0, DISP_BAR_TOP, x1, DISP_BAR_BOTTOM, 0);
+    int h = (int)(state->buffer[slot] * 3.0f); // 5V fills half the bar area
+    if (h > DISP_BAR_MID - DISP_BAR_TOP) h = DISP_BAR_MID - DISP_BAR_TOP;
+    if (h < DISP_BAR_MID - DISP_BAR_BOTTOM) h = DISP_BAR_MID - DISP_BAR_BOTTOM;
+    if (h == 0) {
+        NT_drawShapeI(kNT_line, x0, DISP_BAR_MID, x1, DISP_BAR_MID, 4);
+    } else if (h > 0) {
+        NT_drawShapeI(kNT_rectangle, x0, DISP_BAR_MID - h, x1, DISP_BAR_MID, 8);
+    } else {
+        NT_drawShapeI(kNT_rectangle, x0, DISP_BAR_MID, x1, DISP_BAR_MID - h, 8);
+    }
+    return 2;
+}
+// Appends a string to a label being built, returns the new length
+inline int append_text(char* buf, int len, const char* str) {
+    while (*str) buf[len++] = *str++;
+    return len;
+}
+
+// --- Display ---
+// Only what changed since the previous frame is redrawn: columns step() wrote,
+// the write head, tap letters that moved and labels whose parameter changed.
+// The region is saved after every frame and copied back before the next, so
+// a screen cleared in between costs two copies rather than a repaint.
+// Everything is repainted on the first frame and when the buffer length
+// changes.
+bool draw(_NT_algorithm* self) {
+    _copierAlgorithm* alg = (_copierAlgorithm*)self;
+    CopierMaschineState* state = alg->state;
+    DisplayState& d = state->cold->display;
+    int bufLen = state->bufLen;
+    int ops = 0;
+
+    // Detect Apply's table is built here rather than in step()
+    if (alg->v[kParamDetect] == DETECT_APPLY) publish_detect_table(state);
+
+    uint8_t* region = NT_screen + DISP_TOP * DISP_ROW_BYTES;
+    bool full = !d.drawn || d.bufLen != bufLen;
+    if (!full) memcpy(region, state->cold->screen, DISP_REGION_BYTES);
+    if (full) {
+        NT_drawShapeI(kNT_rectangle, 0, DISP_TOP, 255, DISP_HEAD_Y, 0);
+        NT_drawShapeI(kNT_line, 0, DISP_HEAD_Y, 255, DISP_HEAD_Y, 2);
+        ops += 2;
+        d.bufLen = bufLen;
+        d.headCol = -1;
+        for (int s = 0; s < NUM_STAGES; ++s) d.tapCol[s] = -1;
+        d.labelsValid = false;
+    }
+
+    // Step profile in place of the labels
+    bool profiling = alg->v[kParamProfile] != 0;
+    if (profiling != d.profiling) {
+        d.profiling = profiling;
+        d.labelsValid = false;
+    }
+    const StepProfile& p = state->cold->profile;
+    if (profiling && (!d.labelsValid || d.profileCycles != p.cycles)) {
+        char buf[32];
+        NT_drawShapeI(kNT_rectangle, 0, DISP_LABEL_Y - 6, 255, DISP_LABEL_Y + 1, 0);
+        int len = NT_intToString(buf, p.cycles);
+        len = append_text(buf, len, " cyc ");
+        len += NT_intToString(buf + len, p.edges);
+        len = append_text(buf, len, " edges/");
+        len += NT_intToString(buf + len, p.frames);
+        buf[len] = 0;
+        NT_drawText(0, DISP_LABEL_Y, buf, 15, kNT_textLeft, kNT_textTiny);
+        len = append_text(buf, 0, alg->parameters[kParamCVSource].enumStrings[p.cvSource]);
+        len = append_text(buf, len, p.mode == MODE_AUDIO ? " Aud Len " : p.mode ? " Trk Len " : " Len ");
+        len += NT_intToString(buf + len, p.bufLen);
+        buf[len] = 0;
+        NT_drawText(255, DISP_LABEL_Y, buf, 15, kNT_textRight, kNT_textTiny);
+        ops += 3;
+        d.profileCycles = p.cycles;
+        d.labelsValid = true;
+    }
+
+    // Label row
+    int scale = alg->v[kParamScale];
+    int root = alg->v[kParamRoot];
+    int transpose = alg->v[kParamTranspose];
+    int bufIdx = alg->v[kParamBufIndex];
+    int fit = alg->v[kParamDetect] != DETECT_OFF ? state->cold->detect.fit.load(std::memory_order_relaxed) : -1;
+    if (!profiling && (!d.labelsValid || d.scale != scale || d.root != root || d.transpose != transpose || d.bufIdx != bufIdx || d.fit != fit)) {
+        char buf[48];
+        NT_drawShapeI(kNT_rectangle, 0, DISP_LABEL_Y - 6, 255, DISP_LABEL_Y + 1, 0);
+        if (fit >= 0) {
+            int len = append_text(buf, 0, "Fit ");
+            len = append_text(buf, len, all_scale_names[fit / 12]);
+            buf[len++] = ' ';
+            len = append_text(buf, len, root_names[fit % 12]);
+            buf[len] = 0;
+            NT_drawText(0, DISP_LABEL_Y, buf, 15, kNT_textLeft, kNT_textTiny);
+        } else {
+            NT_drawText(0, DISP_LABEL_Y, all_scale_names[scale], 15, kNT_textLeft, kNT_textTiny);
+        }
+        int len = 0;
+        for (const char* c = root_names[root]; *c; ++c) buf[len++] = *c;
+        buf[len++] = ' ';
+        if (transpose >= 0) buf[len++] = '+';
+        len += NT_intToString(buf + len, transpose);
+        buf[len++] = ' ';
+        buf[len++] = 'I';
+        buf[len++] = 'd';
+        buf[len++] = 'x';
+        buf[len++] = ' ';
+        len += NT_intToString(buf + len, bufIdx);
+        buf[len] = 0;
+        NT_drawText(255, DISP_LABEL_Y, buf, 15, kNT_textRight, kNT_textTiny);
+        ops += 3;
+        d.scale = scale;
+        d.root = root;
+        d.transpose = transpose;
+        d.bufIdx = bufIdx;
+        d.fit = fit;
+        d.labelsValid = true;
+    }
+
+    // Columns written since the last frame
+    int numCols = bufLen < DISP_COLS ? bufLen : DISP_COLS;
+    int newest = (state->writePos - 1 + bufLen) % bufLen;
+    for (int w = 0; w < DISP_COLS / 32; ++w) {
+        uint32_t bits = state->cold->dirtyCols[w].exchange(0, std::memory_order_acquire);
+        if (full) bits = 0xFFFFFFFFu;
+        while (bits) {
+            int col = w * 32 + __builtin_ctz(bits);
+            bits &= bits - 1;
+            if (col < numCols) ops += draw_column(state, col, newest);
+        }
+    }
+
+    // Write head
+    int head = state->writePos < bufLen ? disp_column(state->writePos, bufLen) : -1;
+    if (head != d.headCol) {
+        if (d.headCol >= 0) {
+            int x0 = d.headCol * DISP_COL_W;
+            NT_drawShapeI(kNT_line, x0, DISP_HEAD_Y, x0 + DISP_COL_W - 2, DISP_HEAD_Y, 2);
+            ops++;
+        }
+        if (head >= 0) {
+            int x0 = head * DISP_COL_W;
+            NT_drawShapeI(kNT_line, x0, DISP_HEAD_Y, x0 + DISP_COL_W - 2, DISP_HEAD_Y, 15);
+            ops++;
+        }
+        d.headCol = head;
+    }
+
+    // Stage letters; several stages may share a slot, so the row is rebuilt
+    int tapCol[NUM_STAGES];
+    bool tapsMoved = false;
+    for (int s = 0; s < NUM_STAGES; ++s) {
+        tapCol[s] = disp_column(state->tapIdx[s], bufLen);
+        if (tapCol[s] != d.tapCol[s]) tapsMoved = true;
+    }
+    if (tapsMoved) {
+        NT_drawShapeI(kNT_rectangle, 0, DISP_TAP_Y - 6, 255, DISP_TAP_Y + 1, 0);
+        ops++;
+        for (int s = NUM_STAGES - 1; s >= 0; --s) {
+            char letter[2] = { (char)('A' + s), 0 };
+            d.tapCol[s] = tapCol[s];
+            NT_drawText(d.tapCol[s] * DISP_COL_W, DISP_TAP_Y, letter, 15, kNT_textLeft, kNT_textTiny);
+            ops++;
+        }
+    }
+
+    memcpy(state->cold->screen, region, DISP_REGION_BYTES);
+    d.drawn = true;
+    d.ops = ops;
+    if (ops > d.maxOps) d.maxOps = ops;
+    return false;
+}
+
 // --- Factory definition ---
 static const _NT_factory factory = {
     .guid = NT_MULTICHAR('C','P','M','8'),
     .name = "CopierMaschine8OUTS",
     .description = "Quantizing ASR with a lot of scales, Viznutcracker ByteBeat, Integer Sequences, and scale selection, it has 8 outputs !!!",
-    .numSpecifications = 0,
+    .numSpecifications = kNumSpecs,
+    .specifications = specifications,
     .calculateRequirements = calculateRequirements,
     .construct = construct,
-    .parameterChanged = NULL,
+    .parameterChanged = parameterChanged,
     .step = step,
-    .draw = NULL,
-    .midiMessage = NULL,
+    .draw = draw,
+    .midiMessage = midiMessage,
 };
 
 // --- Plugin entry point ---
@@ -0,0 +1,674 @@
+// --- Host checks ---
+// White-box checks of one plugin build: the plugin source is compiled into
+// this file (PLUGIN_SOURCE) so the checks can look at its state. Exits
+// non-zero if any check fails.
+
+#include "host.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include PLUGIN_SOURCE
+
+static int failures = 0;
+
+#define CHECK(cond, ...) do { \
+    if (!(cond)) { \
+        ++failures; \
+        printf("FAIL %s:%d: ", __FILE__, __LINE__); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } \
+} while (0)
+
+#define FRAMES 32
+
+static uint32_t next_random(uint32_t& s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+// Default ASR length with Audio mode selectable
+static const int32_t audioSpecs[kNumSpecs] = { ASR_DEFAULT_SIZE, 1 };
+
+static CopierMaschineState* state_of(HostInstance& inst) {
+    return ((_copierAlgorithm*)inst.alg)->state;
+}
+
+// Sets the Note 1..12 toggles to the bits of mask
+static void set_mask(HostInstance& inst, int mask) {
+    for (int i = 0; i < NUM_NOTE_TOGGLES; ++i) host_set_param(inst, kParamNote1 + i, (mask >> i) & 1);
+}
+
+// Sets a parameter to a random value in its range
+static void randomise_param(HostInstance& inst, const char* name, uint32_t& rng) {
+    int p = host_find_param(inst, name);
+    if (p < 0) return;
+    const _NT_parameter& param = inst.alg->parameters[p];
+    host_set_param(inst, p, param.min + (int)(next_random(rng) % (param.max - param.min + 1)));
+}
+
+// --- Draw cost ---
+// Every frame issues at most the primitives of what changed: two per dirty
+// column, the labels, the head marker and the tap row. A full repaint is
+// bounded by all columns, and a frame without clock edges or parameter
+// changes draws nothing.
+
+static const char* displayParams[] = { "BufLen", "Scale", "Root", "Transpose", "BufIdx", "TapPat", "Profile", "Detect", "Hold", "Mode" };
+
+static int dirty_columns(CopierMaschineState* state) {
+    int n = 0;
+    for (int w = 0; w < DISP_COLS / 32; ++w)
+        n += __builtin_popcount(state->cold->dirtyCols[w].load(std::memory_order_relaxed));
+    return n;
+}
+
+static void check_draw_ops(void) {
+    const int fullOps = 2 + 3 + 2 * DISP_COLS + 2 + 1 + NUM_STAGES;
+    std::vector<float> buses(HOST_NUM_BUSES * FRAMES, 0.0f);
+    int worst = 0, worstIncremental = 0;
+    for (uint32_t seed = 1; seed <= 20; ++seed) {
+        HostInstance inst;
+        host_construct(inst, &factory, audioSpecs);
+        CopierMaschineState* state = state_of(inst);
+        const DisplayState& d = state->cold->display;
+        HostInputs in;
+        host_init_inputs(in, 3 + seed * 7, seed, 5, seed % HOST_NUM_CV_SHAPES, seed);
+        uint32_t rng = seed;
+        for (int b = 0; b < 2000; ++b) {
+            if (b % 100 == 50) randomise_param(inst, displayParams[next_random(rng) % 10], rng);
+            if (b % 500 == 0) memset(NT_screen, 0, sizeof(NT_screen));
+            host_fill_inputs(in, buses.data(), FRAMES);
+            factory.step(inst.alg, buses.data(), FRAMES / 4);
+
+            bool full = !d.drawn || d.bufLen != state->bufLen;
+            int cols = full ? (state->bufLen < DISP_COLS ? state->bufLen : DISP_COLS) : dirty_columns(state);
+            int bound = (full ? 2 : 0) + 3 + 2 * cols + 2 + 1 + NUM_STAGES;
+            host_draw_ops = 0;
+            factory.draw(inst.alg);
+
+            CHECK(host_draw_ops == d.ops, "seed %u block %d: draw() issued %d primitives, counted %d", seed, b, host_draw_ops, d.ops);
+            CHECK(d.ops <= bound, "seed %u block %d: %d primitives for %d dirty columns, bound %d", seed, b, d.ops, cols, bound);
+            CHECK(d.ops <= fullOps, "seed %u block %d: %d primitives, full repaint is %d", seed, b, d.ops, fullOps);
+            if (d.ops > worst) worst = d.ops;
+            if (!full && d.ops > worstIncremental) worstIncremental = d.ops;
+        }
+    }
+
+    // No clock edges after the first frame and no parameter changes
+    HostInstance inst;
+    host_construct(inst, &factory);
+    HostInputs in;
+    host_init_inputs(in, 1 << 30, 0, 1 << 30, HOST_CV_SINE, 1);
+    for (int b = 0; b < 200; ++b) {
+        host_fill_inputs(in, buses.data(), FRAMES);
+        factory.step(inst.alg, buses.data(), FRAMES / 4);
+        host_draw_ops = 0;
+        factory.draw(inst.alg);
+        if (b >= 2) CHECK(host_draw_ops == 0, "idle block %d drew %d primitives", b, host_draw_ops);
+    }
+    printf("draw ops: full repaint <= %d, worst frame %d, worst incremental frame %d\n", fullOps, worst, worstIncremental);
+}
+
+// --- Cleared screen ---
+// With the screen wiped before every frame, draw() stays incremental: the
+// region it leaves matches a full repaint of the same state, and a frame
+// costs far less than repainting.
+
+static double time_draw(HostInstance& inst, bool full) {
+    const int reps = 2000;
+    DisplayState& d = state_of(inst)->cold->display;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        memset(NT_screen, 0, sizeof(NT_screen));
+        if (full) d.drawn = false;
+        factory.draw(inst.alg);
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / reps;
+}
+
+static void check_draw_cleared(void) {
+    std::vector<float> buses(HOST_NUM_BUSES * FRAMES, 0.0f);
+    std::vector<uint8_t> kept(DISP_REGION_BYTES);
+    const uint8_t* region = NT_screen + DISP_TOP * DISP_ROW_BYTES;
+    int compared = 0, maxOps = 0;
+    for (uint32_t seed = 1; seed <= 10; ++seed) {
+        HostInstance inst;
+        host_construct(inst, &factory, audioSpecs);
+        DisplayState& d = state_of(inst)->cold->display;
+        HostInputs in;
+        host_init_inputs(in, 3 + seed * 7, seed, 5, seed % HOST_NUM_CV_SHAPES, seed);
+        uint32_t rng = seed;
+        for (int b = 0; b < 1000; ++b) {
+            if (b % 100 == 50) randomise_param(inst, displayParams[next_random(rng) % 10], rng);
+            host_fill_inputs(in, buses.data(), FRAMES);
+            factory.step(inst.alg, buses.data(), FRAMES / 4);
+            bool full = !d.drawn || d.bufLen != state_of(inst)->bufLen;
+            memset(NT_screen, 0, sizeof(NT_screen));
+            factory.draw(inst.alg);
+            if (!full && d.ops > maxOps) maxOps = d.ops;
+            if (b % 25 != 24) continue;
+
+            // Repaint the same state from scratch and compare
+            memcpy(kept.data(), region, DISP_REGION_BYTES);
+            memset(NT_screen, 0, sizeof(NT_screen));
+            d.drawn = false;
+            factory.draw(inst.alg);
+            CHECK(!memcmp(kept.data(), region, DISP_REGION_BYTES), "seed %u block %d: cleared-screen frame differs from a full repaint", seed, b);
+            ++compared;
+        }
+    }
+
+    HostInstance inst;
+    host_construct(inst, &factory);
+    HostInputs in;
+    host_init_inputs(in, 7, 0, 5, HOST_CV_SINE, 1);
+    for (int b = 0; b < 100; ++b) {
+        host_fill_inputs(in, buses.data(), FRAMES);
+        factory.step(inst.alg, buses.data(), FRAMES / 4);
+    }
+    factory.draw(inst.alg);
+    double incremental = time_draw(inst, false), full = time_draw(inst, true);
+    CHECK(incremental < full, "a frame on a cleared screen costs %.0f ns, a full repaint %.0f ns", incremental, full);
+    printf("cleared screen: %d frames match full repaints, worst %d primitives; %.0f ns a frame vs %.0f ns repainting\n",
+           compared, maxOps, incremental, full);
+}
+
+// --- Memory placement ---
+// The hot state, quantizer tables included, is requested as DTC and does not
+// grow with the ASR length; the cold state, the ASR history and the audio ring
+// are laid out in DRAM exactly as requested, the ring only when Audio mode can
+// be selected.
+
+static bool inside(const void* p, size_t size, const std::vector<uint8_t>& region) {
+    const uint8_t* b = (const uint8_t*)p;
+    return b >= region.data() && b + size <= region.data() + region.size();
+}
+
+static void check_memory_split(void) {
+    const int32_t lengths[3] = { ASR_MIN_SIZE, ASR_DEFAULT_SIZE, ASR_MAX_SIZE };
+    for (int i = 0; i < 6; ++i) {
+        int32_t capacity = lengths[i / 2];
+        int32_t specs[kNumSpecs] = { capacity, i & 1 };
+        HostInstance inst;
+        host_construct(inst, &factory, specs);
+        CopierMaschineState* state = state_of(inst);
+        uint32_t ring = specs[kSpecAudio] ? audio_ring_len(capacity) : 0;
+        uint32_t dram = sizeof(CopierMaschineCold) + (capacity + 2 * ring) * sizeof(float);
+
+        CHECK(inst.req.sram == sizeof(_copierAlgorithm), "length %d: sram %u, algorithm is %zu", capacity, inst.req.sram, sizeof(_copierAlgorithm));
+        CHECK(inst.req.dtc == sizeof(CopierMaschineState), "length %d: dtc %u, hot state is %zu", capacity, inst.req.dtc, sizeof(CopierMaschineState));
+        CHECK(inst.req.dram == dram, "length %d: dram %u, expected %u", capacity, inst.req.dram, dram);
+        CHECK(inst.req.itc == 0, "length %d: itc %u", capacity, inst.req.itc);
+        CHECK((uint8_t*)state == inst.dtc.data(), "length %d: hot state is not at the DTC region", capacity);
+        CHECK((uint8_t*)state->cold == inst.dram.data(), "length %d: cold state is not at the DRAM region", capacity);
+        CHECK(inside(state->buffer, capacity * sizeof(float), inst.dram), "length %d: ASR buffer outside DRAM", capacity);
+        CHECK((uint8_t*)state->buffer >= (uint8_t*)(state->cold + 1), "length %d: ASR buffer overlaps the cold state", capacity);
+        if (specs[kSpecAudio]) {
+            CHECK(inside(state->audioRing, 2 * ring * sizeof(float), inst.dram), "length %d: audio ring outside DRAM", capacity);
+            CHECK(state->audioRing >= state->buffer + capacity, "length %d: audio ring overlaps the ASR buffer", capacity);
+        } else {
+            CHECK(!state->audioRing, "length %d: audio ring set without the Audio mode specification", capacity);
+            host_set_param(inst, "Mode", MODE_AUDIO);
+            CHECK(inst.v[kParamMode] != MODE_AUDIO, "length %d: Audio mode selectable without the specification", capacity);
+        }
+        CHECK(inside(state->activeTable, sizeof(QuantTable), inst.dtc), "length %d: quantizer table outside DTC", capacity);
+        printf("memory at length %d%s: dtc %u, dram %u, sram %u bytes\n", capacity, specs[kSpecAudio] ? " with Audio mode" : "",
+               inst.req.dtc, inst.req.dram, inst.req.sram);
+    }
+}
+
+// --- Aliased and restrict paths ---
+// Two instances get identical settings and inputs, with no output routed
+// onto CV In; one is forced onto the aliased path. Every output bus must
+// match bit for bit.
+
+static const char* playParams[] = {
+    "Scale", "Root", "Transpose", "Note 1", "Note 5", "Note 8", "MaskRot", "BufIdx", "BufLen", "Hold", "Gain", "CVSrc",
+    "BB Eqn", "BB Rate", "IntSeq", "IntSeqMod", "IntSeqLen", "Mode", "Hyst", "TapPat", "Rnd Lock", "Glide A",
+    "Glide B", "Harmony", "Morph", "Scale B", "Morph Amt", "Detect", "Aud Quant", "MIDI In", "Tap CV",
+    "Morph CV", "Clk B", "Deg B",
+};
+
+#define NUM_PLAY_PARAMS (int)(sizeof(playParams) / sizeof(playParams[0]))
+
+static void check_alias_paths(void) {
+    std::vector<float> busesA(HOST_NUM_BUSES * FRAMES), busesB(HOST_NUM_BUSES * FRAMES);
+    int mismatched = 0;
+    for (uint32_t seed = 1; seed <= 240; ++seed) {
+        HostInstance a, b;
+        host_construct(a, &factory, audioSpecs);
+        host_construct(b, &factory, audioSpecs);
+        HostInputs inA, inB;
+        host_init_inputs(inA, 2 + seed % 61, seed % 7, 3 + seed % 13, seed % HOST_NUM_CV_SHAPES, seed);
+        inB = inA;
+        uint32_t rng = seed;
+        bool failed = false;
+        for (int blk = 0; blk < 600 && !failed; ++blk) {
+            if (blk % 50 == 0) {
+                const char* name = playParams[next_random(rng) % NUM_PLAY_PARAMS];
+                uint32_t saved = rng;
+                randomise_param(a, name, rng);
+                randomise_param(b, name, saved);
+            }
+            host_fill_inputs(inA, busesA.data(), FRAMES);
+            host_fill_inputs(inB, busesB.data(), FRAMES);
+            state_of(b)->busesAlias.store(true, std::memory_order_relaxed);
+            factory.step(a.alg, busesA.data(), FRAMES / 4);
+            factory.step(b.alg, busesB.data(), FRAMES / 4);
+            CHECK(!state_of(a)->busesAlias.load(std::memory_order_relaxed), "seed %u: default routing reported as aliased", seed);
+            if (memcmp(busesA.data(), busesB.data(), busesA.size() * sizeof(float))) {
+                CHECK(false, "seed %u block %d: aliased path output differs", seed, blk);
+                failed = true;
+                ++mismatched;
+            }
+        }
+    }
+    printf("alias paths: 240 seeds, %d mismatched\n", mismatched);
+}
+
+// --- Routed aliases ---
+// Out A routed onto CV In, then onto the Clock bus, must behave as if it were
+// on a spare bus: a reference instance with Out A on bus 25 gets the same
+// settings and inputs, and every bus but those two must match, as must Out A
+// itself. Blocks of 128 frames cover clocks scanned in several chunks. Bus
+// inputs drawn at random may land on CV In or Clock, never on the spare bus.
+
+#define SPARE_BUS 25
+
+static void check_routed_alias(void) {
+    const char* targets[2] = { "CV In", "Clock" };
+    int mismatched = 0;
+    for (int t = 0; t < 2; ++t) {
+        for (uint32_t seed = 1; seed <= 120; ++seed) {
+            int frames = (seed & 1) ? FRAMES : 4 * FRAMES;
+            std::vector<float> busesA(HOST_NUM_BUSES * frames), busesR(HOST_NUM_BUSES * frames);
+            HostInstance a, r;
+            host_construct(a, &factory, audioSpecs);
+            host_construct(r, &factory, audioSpecs);
+            int bus = a.v[host_find_param(a, targets[t])];
+            host_set_param(a, "Out A", bus);
+            host_set_param(r, "Out A", SPARE_BUS);
+            HostInputs inA, inR;
+            host_init_inputs(inA, 2 + seed % 61, seed % 7, 3 + seed % 13, seed % HOST_NUM_CV_SHAPES, seed);
+            inR = inA;
+            uint32_t rng = seed;
+            bool failed = false;
+            for (int blk = 0; blk < 300 && !failed; ++blk) {
+                if (blk % 30 == 0) {
+                    const char* name = playParams[next_random(rng) % NUM_PLAY_PARAMS];
+                    uint32_t saved = rng;
+                    randomise_param(a, name, rng);
+                    randomise_param(r, name, saved);
+                    // The spare bus carries the reference's Out A; nothing else reads it
+                    int p = host_find_param(a, name);
+                    if (a.alg->parameters[p].max == HOST_NUM_BUSES && a.v[p] == SPARE_BUS) {
+                        host_set_param(a, p, 0);
+                        host_set_param(r, p, 0);
+                    }
+                }
+                host_fill_inputs(inA, busesA.data(), frames);
+                host_fill_inputs(inR, busesR.data(), frames);
+                factory.step(a.alg, busesA.data(), frames / 4);
+                factory.step(r.alg, busesR.data(), frames / 4);
+                bool same = !memcmp(busesA.data() + (bus - 1) * frames, busesR.data() + (SPARE_BUS - 1) * frames, frames * sizeof(float));
+                for (int b = 1; b <= HOST_NUM_BUSES; ++b) {
+                    if (b == bus || b == SPARE_BUS) continue;
+                    if (memcmp(busesA.data() + (b - 1) * frames, busesR.data() + (b - 1) * frames, frames * sizeof(float))) same = false;
+                }
+                if (!same) {
+                    CHECK(false, "Out A on %s, seed %u block %d: output differs from Out A on bus %d", targets[t], seed, blk, SPARE_BUS);
+                    failed = true;
+                    ++mismatched;
+                }
+            }
+        }
+    }
+    printf("routed alias: Out A on CV In and on Clock, 240 seeds, %d mismatched\n", mismatched);
+}
+
+// --- Clock look-ahead and stage inputs ---
+// Values worked out ahead of an edge must be the ones the edge would give,
+// and values kept across blocks the ones a refresh would give: a twin
+// instance whose look-ahead and stage inputs are dropped before every block
+// has to produce the same outputs, with Mode switching in and out of Track.
+
+static void check_look_ahead(void) {
+    std::vector<float> busesA(HOST_NUM_BUSES * FRAMES), busesB(HOST_NUM_BUSES * FRAMES);
+    int mismatched = 0;
+    for (uint32_t seed = 1; seed <= 240; ++seed) {
+        HostInstance a, b;
+        host_construct(a, &factory);
+        host_construct(b, &factory);
+        HostInputs inA, inB;
+        host_init_inputs(inA, 2 + seed % 61, seed % 7, 3 + seed % 13, seed % HOST_NUM_CV_SHAPES, seed);
+        inB = inA;
+        uint32_t rng = seed;
+        bool failed = false;
+        for (int blk = 0; blk < 600 && !failed; ++blk) {
+            if (blk % 50 == 0) {
+                const char* name = playParams[next_random(rng) % NUM_PLAY_PARAMS];
+                uint32_t saved = rng;
+                randomise_param(a, name, rng);
+                randomise_param(b, name, saved);
+            }
+            if (blk % 20 == 10) {
+                int mode = next_random(rng) % 2;
+                host_set_param(a, "Mode", mode);
+                host_set_param(b, "Mode", mode);
+            }
+            if (blk % 7 == 3) {
+                int note = 36 + next_random(rng) % 48;
+                factory.midiMessage(a.alg, 0x90, note, 100);
+                factory.midiMessage(b.alg, 0x90, note, 100);
+            }
+            host_fill_inputs(inA, busesA.data(), FRAMES);
+            host_fill_inputs(inB, busesB.data(), FRAMES);
+            if (blk % 10 == 5) {
+                // draw() publishes Detect Apply's table
+                factory.draw(a.alg);
+                factory.draw(b.alg);
+            }
+            state_of(b)->ahead.valid = false;
+            state_of(b)->stageInputs.table = NULL;
+            factory.step(a.alg, busesA.data(), FRAMES / 4);
+            factory.step(b.alg, busesB.data(), FRAMES / 4);
+            if (memcmp(busesA.data(), busesB.data(), busesA.size() * sizeof(float))) {
+                CHECK(false, "seed %u block %d: look-ahead output differs", seed, blk);
+                failed = true;
+                ++mismatched;
+            }
+        }
+    }
+    printf("look-ahead: 240 seeds, %d mismatched\n", mismatched);
+}
+
+// --- Quantizer table handoff ---
+// Settings change between blocks; every table step() swaps in must match one
+// built from scratch and sit in the instance's DTC.
+
+static bool same_table(const QuantTable* a, const QuantTable* b) {
+    if (a->periodic != b->periodic || a->period != b->period || a->invPeriod != b->invPeriod) return false;
+    if (a->numDegrees != b->numDegrees || memcmp(a->degrees, b->degrees, (a->numDegrees + 2) * sizeof(float))) return false;
+    if (a->periodic) return !memcmp(a->bin, b->bin, sizeof(a->bin));
+    return !memcmp(a->offset, b->offset, sizeof(a->offset)) && !memcmp(a->pcVolts, b->pcVolts, sizeof(a->pcVolts));
+}
+
+static void check_table_handoff(void) {
+    std::vector<float> buses(HOST_NUM_BUSES * FRAMES, 0.0f);
+    uint32_t rng = 7;
+    int tables = 0;
+    for (int n = 0; n < 200; ++n) {
+        HostInstance inst;
+        host_construct(inst, &factory);
+        CopierMaschineState* state = state_of(inst);
+        for (int k = 0; k < 4; ++k) {
+            if (k == 1) {
+                set_mask(inst, next_random(rng) % 4096);
+            } else {
+                randomise_param(inst, k == 2 ? "MaskRot" : "Scale", rng);
+            }
+            factory.step(inst.alg, buses.data(), FRAMES / 4);
+            QuantTable built;
+            build_quant_table(&built, inst.v[kParamScale], note_mask(inst.v.data()), inst.v[kParamMaskRotate]);
+            CHECK(same_table(state->scaleTable, &built), "instance %d: table for scale %d mask %d rot %d differs from a fresh build",
+                  n, inst.v[kParamScale], note_mask(inst.v.data()), inst.v[kParamMaskRotate]);
+            CHECK(inside(state->scaleTable, sizeof(QuantTable), inst.dtc), "instance %d: quantizer table outside DTC", n);
+            ++tables;
+        }
+    }
+    printf("table handoff: %d tables over 200 instances match fresh builds\n", tables);
+}
+
+// Detect Apply's table is published by draw() once a sweep finishes: after
+// the next block step() must quantize with the table for the latest fit, and
+// never build one itself.
+
+static void check_detect_handoff(void) {
+    std::vector<float> buses(HOST_NUM_BUSES * FRAMES);
+    int tables = 0;
+    for (uint32_t seed = 1; seed <= 40; ++seed) {
+        HostInstance inst;
+        host_construct(inst, &factory);
+        host_set_param(inst, "Detect", DETECT_APPLY);
+        CopierMaschineState* state = state_of(inst);
+        HostInputs in;
+        host_init_inputs(in, 2 + seed % 5, seed % 7, 3 + seed % 13, seed % HOST_NUM_CV_SHAPES, seed);
+        int fit = -1;
+        for (int blk = 0; blk < 2000; ++blk) {
+            host_fill_inputs(in, buses.data(), FRAMES);
+            factory.step(inst.alg, buses.data(), FRAMES / 4);
+            CHECK(state->cold->detect.tableFit == fit, "seed %u block %d: step() built a detect table", seed, blk);
+            if (fit >= 0 && blk % 10 == 1) {
+                QuantTable built;
+                build_detect_table(&built, fit);
+                CHECK(state->activeTable == state->detectTable && same_table(state->detectTable, &built),
+                      "seed %u block %d: not quantizing with the table for fit %d", seed, blk, fit);
+                ++tables;
+            }
+            if (blk % 10 == 0) {
+                factory.draw(inst.alg);
+                fit = state->cold->detect.fit.load(std::memory_order_relaxed);
+            }
+        }
+    }
+    printf("detect handoff: %d tables over 40 instances match fresh builds\n", tables);
+}
+
+// --- Batch quantization ---
+// quantize_batch() gives what one quantize_note() call per value gives, to
+// within a float step of the volts, for every scale, random masks and the
+// morph tables. Then times both over NUM_STAGES values, the size of a stage
+// refresh, and over an audio chunk.
+
+static double time_quantize(const QuantTable* table, const float* in, float* out, int count, bool batch) {
+    const int reps = 20000;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < reps; ++r) {
+        if (batch) {
+            quantize_batch(table, in, out, count, r & 7);
+        } else {
+            for (int i = 0; i < count; ++i) out[i] = quantize_note(table, static_cast<int>(roundf(in[i] * 12.0f)) + (r & 7)) / 12.0f;
+        }
+        __asm__ volatile("" : : "r"(out) : "memory");
+    }
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count() / (reps * count);
+}
+
+static void check_quantize_batch(void) {
+    uint32_t rng = 5;
+    float in[AUDIO_CHUNK], got[AUDIO_CHUNK];
+    int values = 0;
+    std::vector<QuantTable> morph(MORPH_STEPS);
+    for (int scale = 0; scale < NUM_SCALES; ++scale) {
+        for (int trial = 0; trial < 4; ++trial) {
+            QuantTable t;
+            int mask = trial ? (int)(next_random(rng) % 4096) : 4095;
+            build_quant_table(&t, scale, mask, next_random(rng) % 16);
+            build_morph_tables(morph.data(), scale, next_random(rng) % NUM_SCALES, mask, 0);
+            for (int m = -1; m < MORPH_STEPS; ++m) {
+                const QuantTable* table = (m < 0) ? &t : &morph[m];
+                for (int k = 0; k < 8; ++k) {
+                    int offset = (int)(next_random(rng) % 71) - 35;
+                    for (int i = 0; i < AUDIO_CHUNK; ++i) {
+                        int n = (int)(next_random(rng) % 481) - 240;
+                        if (i % 3 == 0) in[i] = n / 12.0f;
+                        else if (i % 3 == 1) in[i] = (n + 0.5f) / 12.0f;
+                        else in[i] = (next_random(rng) >> 8) * (24.0f / 16777216.0f) - 12.0f;
+                    }
+                    quantize_batch(table, in, got, AUDIO_CHUNK, offset);
+                    for (int i = 0; i < AUDIO_CHUNK; ++i) {
+                        float want = quantize_note(table, static_cast<int>(roundf(in[i] * 12.0f)) + offset) / 12.0f;
+                        CHECK(fabsf(got[i] - want) <= 4e-7f * fmaxf(1.0f, fabsf(want)), "scale %d mask %d: %f V gives %.9f, per value %.9f",
+                              scale, mask, in[i], got[i], want);
+                        ++values;
+                    }
+                }
+            }
+        }
+    }
+
+    QuantTable t;
+    build_quant_table(&t, 1, 4095, 0);
+    for (int i = 0; i < AUDIO_CHUNK; ++i) in[i] = (next_random(rng) >> 8) * (20.0f / 16777216.0f) - 10.0f;
+    double stagesBatch = time_quantize(&t, in, got, NUM_STAGES, true), stagesSingle = time_quantize(&t, in, got, NUM_STAGES, false);
+    double chunkBatch = time_quantize(&t, in, got, AUDIO_CHUNK, true), chunkSingle = time_quantize(&t, in, got, AUDIO_CHUNK, false);
+    printf("quantize batch: %d values match; %d values %.2f ns each vs %.2f per call (%.1fx), %d values %.2f vs %.2f (%.1fx)\n",
+           values, NUM_STAGES, stagesBatch, stagesSingle, stagesSingle / stagesBatch, AUDIO_CHUNK, chunkBatch, chunkSingle, chunkSingle / chunkBatch);
+}
+
+// --- Masked degrees ---
+// With any mask, a note quantizes to the nearest enabled degree in any
+// period, ties going down, and the harmonizer steps from that degree through
+// enabled degrees only. Covers the tritave scales and the standard ones,
+// including masks without the root.
+
+static int scale_index(const char* name) {
+    for (int i = 0; i < NUM_SCALES; ++i)
+        if (!strcmp(all_scale_names[i], name)) return i;
+    return -1;
+}
+
+// Every enabled degree from period -30 to 30, ascending
+static void degree_grid(const QuantTable* t, std::vector<float>& grid) {
+    grid.clear();
+    for (int k = -30; k <= 30; ++k)
+        for (int d = 0; d < t->numDegrees; ++d)
+            grid.push_back(k * t->period + t->degrees[d]);
+}
+
+static void check_masked_degrees(void) {
+    QuantTable t;
+    int bp = scale_index("BP Equal");
+    build_quant_table(&t, bp, 1, 5);
+    for (int n = 14; n <= 18; ++n)
+        CHECK(fabsf(quantize_note(&t, n) - TRITAVE_SEMITONES) > 0.1f, "BP Equal mask 1 rot 5: note %d gives the masked root", n);
+
+    std::vector<float> grid;
+    std::vector<float> buses(HOST_NUM_BUSES * FRAMES, 0.0f);
+    uint32_t rng = 11;
+    int tables = 0;
+    for (int scale = 0; scale < NUM_SCALES; ++scale) {
+        if (scale >= NUM_STANDARD_SCALES && scale < NUM_SCALES - NUM_TRITAVE_SCALES) continue;
+        for (int trial = 0; trial < 40; ++trial) {
+            int mask = (trial % 4 == 0) ? (1 << (next_random(rng) % 12)) : (int)(next_random(rng) % 4096);
+            int rot = next_random(rng) % 16;
+            HostInstance inst;
+            host_construct(inst, &factory);
+            host_set_param(inst, "Harmony", 1);
+            host_set_param(inst, "Scale", scale);
+            set_mask(inst, mask);
+            host_set_param(inst, "MaskRot", rot);
+            for (int s = 1; s < NUM_STAGES; ++s)
+                host_set_param(inst, kParamDegB + s - 1, (int)(next_random(rng) % 29) - 14);
+            factory.step(inst.alg, buses.data(), FRAMES / 4);
+            CopierMaschineState* state = state_of(inst);
+            const QuantTable* table = state->activeTable;
+            degree_grid(table, grid);
+            ++tables;
+
+            for (int n = -60; n <= 60; ++n) {
+                size_t up = 0;
+                while (grid[up] <= n) ++up;
+                float lo = grid[up - 1], hi = grid[up];
+                float expected = (hi - n < n - lo) ? hi : lo;
+                float got = quantize_note(table, n);
+                bool tie = fabsf((hi - n) - (n - lo)) < 1e-3f;
+                CHECK(tie || fabsf(got - expected) < 1e-3f, "scale %d mask %d rot %d: note %d gives %f, nearest is %f", scale, mask, rot, n, got, expected);
+
+                size_t at = (fabsf(got - lo) < fabsf(got - hi)) ? up - 1 : up;
+                float dst[NUM_STAGES];
+                harmonize(state, got, dst);
+                for (int s = 0; s < NUM_STAGES; ++s) {
+                    float want = grid[at + state->harmDegree[s]];
+                    CHECK(fabsf(dst[s] * 12.0f - want) < 1e-3f, "scale %d mask %d rot %d: note %d stage %d gives %f, expected %f",
+                          scale, mask, rot, n, s, dst[s] * 12.0f, want);
+                }
+            }
+        }
+    }
+    printf("masked degrees: %d tables, notes -60..60 match the nearest enabled degree\n", tables);
+}
+
+// --- Audio mode ---
+// Random with Lock at 100 and Hold both loop the last BufLen samples of the
+// audio ring, MIDI note-ons leave the ASR alone, and a clock that rose while
+// Audio mode ignored it gives no edge once the mode switches back.
+
+static void check_audio_mode(void) {
+    std::vector<float> buses(HOST_NUM_BUSES * FRAMES, 0.0f);
+    const int lengths[3] = { 5, 16, 57 };
+    for (int k = 0; k < 6; ++k) {
+        int bufLen = lengths[k / 2];
+        bool hold = k & 1;
+        HostInstance inst;
+        host_construct(inst, &factory, audioSpecs);
+        host_set_param(inst, "Mode", MODE_AUDIO);
+        host_set_param(inst, "CVSrc", 3);
+        host_set_param(inst, "BufLen", bufLen);
+        for (int b = 0; b < 10; ++b) factory.step(inst.alg, buses.data(), FRAMES / 4);
+        host_set_param(inst, hold ? "Hold" : "Rnd Lock", hold ? 1 : 100);
+        for (int b = 0; b < 10; ++b) factory.step(inst.alg, buses.data(), FRAMES / 4);
+        CopierMaschineState* state = state_of(inst);
+        int len = audio_ring_len(state->capacity);
+        int looped = 0, changes = 0, span = len - bufLen;
+        for (int i = 1; i <= span; ++i) {
+            int at = (state->audioPos - i + len) % len;
+            int back = (at - bufLen + len) % len;
+            if (state->audioRing[at] == state->audioRing[back]) ++looped;
+            if (state->audioRing[at] != state->audioRing[(at - 1 + len) % len]) ++changes;
+        }
+        const char* what = hold ? "held" : "locked";
+        CHECK(looped == span, "BufLen %d: %d of %d %s samples repeat BufLen back", bufLen, looped, span, what);
+        CHECK(changes > 0, "BufLen %d: %s samples are one value, not a loop", bufLen, what);
+    }
+
+    HostInstance midi;
+    host_construct(midi, &factory, audioSpecs);
+    host_set_param(midi, "MIDI In", MIDI_IN_NOTE_ON);
+    host_set_param(midi, "Mode", MODE_AUDIO);
+    CopierMaschineState* midiState = state_of(midi);
+    std::vector<float> asr(midiState->buffer, midiState->buffer + midiState->capacity);
+    for (int b = 0; b < 8; ++b) {
+        factory.midiMessage(midi.alg, 0x90, 60 + b, 100);
+        factory.step(midi.alg, buses.data(), FRAMES / 4);
+    }
+    CHECK(midiState->writePos == 0 && !memcmp(asr.data(), midiState->buffer, asr.size() * sizeof(float)),
+          "MIDI note-ons were written into the ASR in Audio mode");
+    CHECK(midiState->midiValue == (67 - MIDI_NOTE_ZERO_V) / 12.0f, "MIDI In value not kept current in Audio mode");
+
+    HostInstance inst;
+    host_construct(inst, &factory, audioSpecs);
+    CopierMaschineState* state = state_of(inst);
+    float* clock = buses.data() + FRAMES;
+    factory.step(inst.alg, buses.data(), FRAMES / 4);
+    host_set_param(inst, "Mode", MODE_AUDIO);
+    for (int i = 0; i < FRAMES; ++i) clock[i] = 5.0f;
+    factory.step(inst.alg, buses.data(), FRAMES / 4);
+    host_set_param(inst, "Mode", 0);
+    int writePos = state->writePos;
+    factory.step(inst.alg, buses.data(), FRAMES / 4);
+    CHECK(state->writePos == writePos, "a clock held high through Audio mode gave an edge on the way back");
+    printf("audio mode: Lock and Hold loop BufLen samples, MIDI In leaves the ASR, clock levels carried across\n");
+}
+
+int main(void) {
+    printf("%s\n", factory.name);
+    check_draw_ops();
+    check_draw_cleared();
+    check_memory_split();
+    check_alias_paths();
+    check_routed_alias();
+    check_look_ahead();
+    check_table_handoff();
+    check_detect_handoff();
+    check_quantize_batch();
+    check_masked_degrees();
+    check_audio_mode();
+    printf(failures ? "%d checks failed\n" : "all checks passed\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,117 @@
+#include "host.h"
+#include <cmath>
+#include <cstring>
+#include <map>
+
+// --- Factory and instance setup ---
+
+static std::map<const _NT_factory*, std::vector<uint8_t> > staticMemory;
+
+void host_initialise_factory(const _NT_factory* factory) {
+    if (!factory->calculateStaticRequirements || staticMemory.count(factory)) return;
+    _NT_staticRequirements req;
+    memset(&req, 0, sizeof(req));
+    factory->calculateStaticRequirements(req);
+    std::vector<uint8_t>& mem = staticMemory[factory];
+    mem.assign(req.dram, 0);
+    _NT_staticMemoryPtrs ptrs;
+    memset(&ptrs, 0, sizeof(ptrs));
+    ptrs.dram = mem.data();
+    factory->initialise(ptrs, req);
+}
+
+void host_construct(HostInstance& inst, const _NT_factory* factory, const int32_t* specs) {
+    host_initialise_factory(factory);
+    inst.factory = factory;
+    for (uint32_t i = 0; i < HOST_MAX_SPECS; ++i)
+        inst.specs[i] = (i < factory->numSpecifications) ? (specs ? specs[i] : factory->specifications[i].def) : 0;
+
+    memset(&inst.req, 0, sizeof(inst.req));
+    factory->calculateRequirements(inst.req, inst.specs);
+    inst.sram.assign(inst.req.sram, 0);
+    inst.dram.assign(inst.req.dram, 0);
+    inst.dtc.assign(inst.req.dtc, 0);
+    inst.itc.assign(inst.req.itc, 0);
+
+    _NT_algorithmMemoryPtrs ptrs;
+    ptrs.sram = inst.sram.data();
+    ptrs.dram = inst.dram.data();
+    ptrs.dtc = inst.dtc.data();
+    ptrs.itc = inst.itc.data();
+    inst.alg = factory->construct(ptrs, inst.req, inst.specs);
+
+    inst.v.resize(inst.req.numParameters);
+    for (uint32_t p = 0; p < inst.req.numParameters; ++p)
+        inst.v[p] = inst.alg->parameters[p].def;
+    inst.alg->v = inst.v.data();
+    inst.alg->vIncludingCommon = inst.v.data();
+    if (factory->parameterChanged)
+        for (uint32_t p = 0; p < inst.req.numParameters; ++p)
+            factory->parameterChanged(inst.alg, p);
+}
+
+int host_find_param(const HostInstance& inst, const char* name) {
+    for (uint32_t p = 0; p < inst.req.numParameters; ++p)
+        if (!strcmp(inst.alg->parameters[p].name, name)) return p;
+    return -1;
+}
+
+void host_set_param(HostInstance& inst, int p, int value) {
+    const _NT_parameter& param = inst.alg->parameters[p];
+    if (value < param.min) value = param.min;
+    if (value > param.max) value = param.max;
+    inst.v[p] = value;
+    if (inst.factory->parameterChanged) inst.factory->parameterChanged(inst.alg, p);
+}
+
+bool host_set_param(HostInstance& inst, const char* name, int value) {
+    int p = host_find_param(inst, name);
+    if (p < 0) return false;
+    host_set_param(inst, p, value);
+    return true;
+}
+
+// --- Generated inputs ---
+
+static uint32_t next_random(uint32_t& s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+void host_init_inputs(HostInputs& in, int clockPeriod, int clockPhase, int auxPeriod, int cvShape, uint32_t seed) {
+    in.clockPeriod = clockPeriod < 2 ? 2 : clockPeriod;
+    in.clockPhase = clockPhase % in.clockPeriod;
+    in.auxPeriod = auxPeriod < 2 ? 2 : auxPeriod;
+    in.cvShape = cvShape;
+    in.rng = seed ? seed : 1;
+    in.frame = 0;
+    in.held = 0.0f;
+}
+
+void host_fill_inputs(HostInputs& in, float* busFrames, int numFrames) {
+    float* cv = busFrames;
+    float* clock = busFrames + numFrames;
+    float* aux = busFrames + 2 * numFrames;
+    float* mod = busFrames + 3 * numFrames;
+    for (int i = 0; i < numFrames; ++i) {
+        uint32_t f = in.frame + i;
+        switch (in.cvShape) {
+            case HOST_CV_NOISE:
+                cv[i] = (next_random(in.rng) >> 8) * (10.0f / 16777216.0f) - 5.0f;
+                break;
+            case HOST_CV_STEPS:
+                if (f % 97 == 0) in.held = (next_random(in.rng) >> 8) * (10.0f / 16777216.0f) - 5.0f;
+                cv[i] = in.held;
+                break;
+            default:
+                cv[i] = 3.0f * sinf(f * 0.0013f) + 0.7f * sinf(f * 0.031f);
+                break;
+        }
+        clock[i] = ((f + in.clockPeriod - in.clockPhase) % in.clockPeriod == 0) ? 5.0f : 0.0f;
+        aux[i] = (f % in.auxPeriod == 0) ? 5.0f : 0.0f;
+        mod[i] = 2.5f + 2.5f * sinf(f * 0.0007f);
+    }
+    in.frame += numFrames;
+}
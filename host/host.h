@@ -0,0 +1,55 @@
+// --- Host harness ---
+// Runs the plugin factories on a desktop machine: memory regions the module
+// would hand out, parameter access by name and generated input buses.
+
+#pragma once
+
+#include <distingnt/api.h>
+#include <cstdint>
+#include <vector>
+
+#define HOST_NUM_BUSES 28
+#define HOST_MAX_SPECS 4
+
+// Counters kept by the stubbed NT_ functions
+extern int host_draw_ops;
+extern int host_midi_messages;
+
+struct HostInstance {
+    const _NT_factory* factory;
+    _NT_algorithm* alg;
+    _NT_algorithmRequirements req;
+    int32_t specs[HOST_MAX_SPECS];
+    std::vector<uint8_t> sram, dram, dtc, itc;  // Private memory regions
+    std::vector<int16_t> v;                     // Parameter values
+};
+
+// Static memory is set up once per factory, as the module does at load
+void host_initialise_factory(const _NT_factory* factory);
+
+// Constructs an instance with every parameter at its default; specs == NULL
+// takes the default specifications
+void host_construct(HostInstance& inst, const _NT_factory* factory, const int32_t* specs = NULL);
+
+int host_find_param(const HostInstance& inst, const char* name);    // -1 if absent
+void host_set_param(HostInstance& inst, int p, int value);           // Clamped to range
+bool host_set_param(HostInstance& inst, const char* name, int value);
+
+// --- Generated inputs ---
+// CV In on bus 1, the clock on bus 2, a second clock on bus 3 and a slow
+// modulation CV on bus 4, matching the plugins' default routing.
+
+enum { HOST_CV_SINE, HOST_CV_NOISE, HOST_CV_STEPS, HOST_NUM_CV_SHAPES };
+
+struct HostInputs {
+    int clockPeriod;    // Frames between clock edges on bus 2, >= 2
+    int clockPhase;     // Frame offset of those edges
+    int auxPeriod;      // Frames between clock edges on bus 3, >= 2
+    int cvShape;
+    uint32_t rng;
+    uint32_t frame;     // Frames generated so far
+    float held;         // Current level of the stepped CV
+};
+
+void host_init_inputs(HostInputs& in, int clockPeriod, int clockPhase, int auxPeriod, int cvShape, uint32_t seed);
+void host_fill_inputs(HostInputs& in, float* busFrames, int numFrames);
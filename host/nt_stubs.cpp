@@ -0,0 +1,75 @@
+// --- Stubbed NT API ---
+// Host stand-ins for what the module provides. Drawing counts primitives and
+// fills NT_screen: shapes pixel for pixel, text as one block per character
+// coloured by its code, so equal screens mean equal drawing. MIDI is counted
+// and dropped, and the cycle counter reads the host's steady clock in
+// nanoseconds.
+
+#include "host.h"
+#include <chrono>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+int host_draw_ops = 0;
+int host_midi_messages = 0;
+
+uint8_t NT_screen[128 * 64];
+
+static float workBuffer[16384];
+
+const _NT_globals NT_globals = {
+    .sampleRate = 48000,
+    .maxFramesPerStep = 256,
+    .workBuffer = workBuffer,
+    .workBufferSizeBytes = sizeof(workBuffer),
+};
+
+// 256 x 64 pixels, two 4-bit pixels per byte, the even one in the low nibble
+static void set_pixel(int x, int y, int colour) {
+    if (x < 0 || x > 255 || y < 0 || y > 63) return;
+    uint8_t& b = NT_screen[y * 128 + x / 2];
+    b = (x & 1) ? (uint8_t)((b & 0x0F) | (colour << 4)) : (uint8_t)((b & 0xF0) | (colour & 15));
+}
+
+void NT_drawText(int x, int y, const char* str, int colour, _NT_textAlignment align, _NT_textSize size) {
+    ++host_draw_ops;
+    int w = 4 * (int)strlen(str);
+    int left = (align == kNT_textRight) ? x - w : (align == kNT_textCentre) ? x - w / 2 : x;
+    for (int i = 0; str[i]; ++i)
+        for (int py = y - 4; py <= y; ++py)
+            for (int px = 0; px < 3; ++px) set_pixel(left + 4 * i + px, py, (str[i] + colour) % 15 + 1);
+}
+
+void NT_drawShapeI(_NT_shape shape, int x0, int y0, int x1, int y1, int colour) {
+    ++host_draw_ops;
+    if (x0 > x1) std::swap(x0, x1);
+    if (y0 > y1) std::swap(y0, y1);
+    if (shape == kNT_rectangle) {
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x) set_pixel(x, y, colour);
+    } else if (shape == kNT_box) {
+        for (int x = x0; x <= x1; ++x) { set_pixel(x, y0, colour); set_pixel(x, y1, colour); }
+        for (int y = y0; y <= y1; ++y) { set_pixel(x0, y, colour); set_pixel(x1, y, colour); }
+    } else if (shape == kNT_line && (x0 == x1 || y0 == y1)) {
+        for (int y = y0; y <= y1; ++y)
+            for (int x = x0; x <= x1; ++x) set_pixel(x, y, colour);
+    } else {
+        // Points, and the ends of diagonal lines, which the plugins never draw
+        set_pixel(x0, y0, colour);
+        if (shape == kNT_line) set_pixel(x1, y1, colour);
+    }
+}
+
+int NT_intToString(char* buffer, int32_t value) {
+    return sprintf(buffer, "%d", (int)value);
+}
+
+uint32_t NT_getCpuCycleCount(void) {
+    return (uint32_t)std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void NT_sendMidi3ByteMessage(uint32_t destination, uint8_t b0, uint8_t b1, uint8_t b2) {
+    ++host_midi_messages;
+}
@@ -0,0 +1,240 @@
+// --- Rack runtime ---
+// Loads plugin libraries through pluginEntry and runs N instances, spread
+// over every factory found, with private memory regions. Worker threads step
+// their share of the instances block by block, meeting at a barrier after
+// every block, and change scale settings as they go so tables are published
+// from several threads. Reports throughput, per-instance block-time
+// jitter and scaling from one thread to all cores. Every run's outputs are
+// compared with the single-thread run, which catches mutable state shared
+// between instances.
+
+#include "host.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dlfcn.h>
+#include <thread>
+
+#define SETTING_BLOCKS 64   // Blocks between scale setting changes
+
+typedef uintptr_t (*PluginEntry)(_NT_selector selector, uint32_t data);
+
+// --- Settings ---
+// Parameters each instance draws at random
+
+static const char* rackParams[] = {
+    "Scale", "Root", "MaskRot", "BufLen", "Mode", "Hyst", "TapPat", "Rnd Lock", "Glide A",
+    "Glide B", "Harmony", "Morph", "Scale B", "Morph Amt", "Detect", "IntSeq", "Aud Quant", "CVSrc",
+    "BB Eqn", "BB Rate", "BB Out", "BB LPF",
+};
+
+#define NUM_RACK_PARAMS (int)(sizeof(rackParams) / sizeof(rackParams[0]))
+
+// The scale degree toggles, all drawn at setup and one at a time later
+static const char* noteParams[] = {
+    "Note 1", "Note 2", "Note 3", "Note 4", "Note 5", "Note 6",
+    "Note 7", "Note 8", "Note 9", "Note 10", "Note 11", "Note 12",
+};
+
+#define NUM_NOTE_PARAMS (int)(sizeof(noteParams) / sizeof(noteParams[0]))
+
+static uint32_t next_random(uint32_t& s) {
+    s ^= s << 13;
+    s ^= s >> 17;
+    s ^= s << 5;
+    return s;
+}
+
+static void randomise(HostInstance& inst, const char* name, uint32_t& rng) {
+    int p = host_find_param(inst, name);
+    if (p < 0) return;
+    const _NT_parameter& param = inst.alg->parameters[p];
+    host_set_param(inst, p, param.min + (int)(next_random(rng) % (param.max - param.min + 1)));
+}
+
+// --- Instances ---
+
+struct RackInstance {
+    const _NT_factory* factory;
+    HostInstance host;
+    HostInputs in;
+    std::vector<float> buses;
+    uint32_t rng;
+    uint64_t digest;        // FNV-1a over every output bus
+    double minNs, maxNs, sumNs, sumSqNs;
+};
+
+static void setup_instance(RackInstance& r, int index, int frames) {
+    r.rng = 0x9E3779B9u * (index + 1);
+    int32_t specs[HOST_MAX_SPECS] = { r.factory->specifications[0].def, index & 1 }; // Audio mode on odd instances
+    host_construct(r.host, r.factory, specs);
+    for (int i = 0; i < NUM_RACK_PARAMS; ++i) randomise(r.host, rackParams[i], r.rng);
+    for (int i = 0; i < NUM_NOTE_PARAMS; ++i) randomise(r.host, noteParams[i], r.rng);
+    host_init_inputs(r.in, 2 + next_random(r.rng) % 200, next_random(r.rng) % 200, 2 + next_random(r.rng) % 50,
+                     next_random(r.rng) % HOST_NUM_CV_SHAPES, r.rng);
+    r.buses.assign(HOST_NUM_BUSES * frames, 0.0f);
+    r.digest = 14695981039346656037ull;
+    r.minNs = 1e30;
+    r.maxNs = r.sumNs = r.sumSqNs = 0.0;
+}
+
+static void run_block(RackInstance& r, int block, int frames) {
+    if (block % SETTING_BLOCKS == SETTING_BLOCKS - 1) {
+        randomise(r.host, "Scale", r.rng);
+        randomise(r.host, noteParams[next_random(r.rng) % NUM_NOTE_PARAMS], r.rng);
+        randomise(r.host, "MaskRot", r.rng);
+    }
+    host_fill_inputs(r.in, r.buses.data(), frames);
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    r.factory->step(r.host.alg, r.buses.data(), frames / 4);
+    std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+    double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+    if (ns < r.minNs) r.minNs = ns;
+    if (ns > r.maxNs) r.maxNs = ns;
+    r.sumNs += ns;
+    r.sumSqNs += ns * ns;
+
+    // Outputs of both builds live on buses 13-20
+    const uint8_t* bytes = (const uint8_t*)(r.buses.data() + 12 * frames);
+    for (size_t i = 0; i < 8 * frames * sizeof(float); ++i) {
+        r.digest ^= bytes[i];
+        r.digest *= 1099511628211ull;
+    }
+}
+
+// --- Block barrier ---
+// Spins with a yield, so it only suits as many threads as there are cores.
+
+struct Barrier {
+    std::atomic<int> arrived;
+    std::atomic<int> generation;
+    int count;
+};
+
+static void barrier_wait(Barrier& b) {
+    int gen = b.generation.load(std::memory_order_acquire);
+    if (b.arrived.fetch_add(1, std::memory_order_acq_rel) + 1 == b.count) {
+        b.arrived.store(0, std::memory_order_relaxed);
+        b.generation.fetch_add(1, std::memory_order_release);
+    } else {
+        while (b.generation.load(std::memory_order_acquire) == gen) std::this_thread::yield();
+    }
+}
+
+// --- Runs ---
+
+struct Run {
+    std::vector<RackInstance>* instances;
+    Barrier barrier;
+    int threads, blocks, frames;
+};
+
+// Worker t owns instances t, t + threads, ...; it sets them up itself
+static void worker(Run* run, int t) {
+    std::vector<RackInstance>& all = *run->instances;
+    for (size_t i = t; i < all.size(); i += run->threads) setup_instance(all[i], (int)i, run->frames);
+    barrier_wait(run->barrier);
+    for (int b = 0; b < run->blocks; ++b) {
+        for (size_t i = t; i < all.size(); i += run->threads) run_block(all[i], b, run->frames);
+        barrier_wait(run->barrier);
+    }
+}
+
+static double run_rack(std::vector<RackInstance>& instances, int threads, int blocks, int frames) {
+    Run run;
+    run.instances = &instances;
+    run.barrier.arrived.store(0);
+    run.barrier.generation.store(0);
+    run.barrier.count = threads;
+    run.threads = threads;
+    run.blocks = blocks;
+    run.frames = frames;
+    std::vector<std::thread> pool;
+    std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+    for (int t = 1; t < threads; ++t) pool.push_back(std::thread(worker, &run, t));
+    worker(&run, 0);
+    for (size_t t = 0; t < pool.size(); ++t) pool[t].join();
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+}
+
+// --- Plugin discovery ---
+
+static bool load_plugin(const char* path, std::vector<const _NT_factory*>& factories) {
+    void* lib = dlopen(path, RTLD_NOW | RTLD_LOCAL);
+    if (!lib) {
+        fprintf(stderr, "%s\n", dlerror());
+        return false;
+    }
+    PluginEntry entry = (PluginEntry)dlsym(lib, "pluginEntry");
+    if (!entry) {
+        fprintf(stderr, "%s: no pluginEntry\n", path);
+        return false;
+    }
+    uint32_t version = entry(kNT_selector_version, 0);
+    uint32_t count = entry(kNT_selector_numFactories, 0);
+    for (uint32_t i = 0; i < count; ++i) {
+        const _NT_factory* f = (const _NT_factory*)entry(kNT_selector_factoryInfo, i);
+        if (!f) continue;
+        host_initialise_factory(f);
+        factories.push_back(f);
+        printf("%s: %s (API %u)\n", path, f->name, version);
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    int numInstances = 16, blocks = 2000, frames = 32;
+    int maxThreads = (int)std::thread::hardware_concurrency();
+    std::vector<const _NT_factory*> factories;
+    for (int i = 1; i < argc; ++i) {
+        if (!strcmp(argv[i], "-n") && i + 1 < argc) numInstances = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-b") && i + 1 < argc) blocks = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "-f") && i + 1 < argc) frames = atoi(argv[++i]) & ~3;
+        else if (!strcmp(argv[i], "-t") && i + 1 < argc) maxThreads = atoi(argv[++i]);
+        else if (!load_plugin(argv[i], factories)) return 1;
+    }
+    if (factories.empty()) {
+        fprintf(stderr, "usage: rack [-n instances] [-b blocks] [-f frames] [-t threads] plugin.so...\n");
+        return 1;
+    }
+    if (maxThreads < 1) maxThreads = 1;
+    if (frames < 4) frames = 4;
+    if (frames > (int)NT_globals.maxFramesPerStep) frames = NT_globals.maxFramesPerStep;
+
+    double audioSeconds = (double)blocks * frames / NT_globals.sampleRate;
+    printf("%d instances, %d blocks of %d frames (%.2f s of audio each)\n", numInstances, blocks, frames, audioSeconds);
+    printf("threads  wall ms  blocks/s  realtime x  speedup  worst jitter ns  mean sd ns  mismatches\n");
+
+    std::vector<uint64_t> reference;
+    double baseWall = 0.0;
+    int failures = 0;
+    std::vector<int> threadCounts;
+    for (int t = 1; t < maxThreads; t *= 2) threadCounts.push_back(t);
+    threadCounts.push_back(maxThreads);
+    for (size_t c = 0; c < threadCounts.size(); ++c) {
+        int threads = threadCounts[c];
+        std::vector<RackInstance> instances(numInstances);
+        for (int i = 0; i < numInstances; ++i) instances[i].factory = factories[i % factories.size()];
+        double wall = run_rack(instances, threads, blocks, frames);
+        if (threads == 1) baseWall = wall;
+
+        double worstJitter = 0.0, meanSd = 0.0;
+        int mismatches = 0;
+        for (int i = 0; i < numInstances; ++i) {
+            const RackInstance& r = instances[i];
+            double mean = r.sumNs / blocks;
+            meanSd += sqrt(fmax(r.sumSqNs / blocks - mean * mean, 0.0)) / numInstances;
+            if (r.maxNs - r.minNs > worstJitter) worstJitter = r.maxNs - r.minNs;
+            if (threads == 1) reference.push_back(r.digest);
+            else if (r.digest != reference[i]) ++mismatches;
+        }
+        failures += mismatches;
+        printf("%7d  %7.1f  %8.0f  %10.1f  %7.2f  %15.0f  %10.0f  %10d\n", threads, wall * 1000.0,
+               numInstances * blocks / wall, numInstances * audioSeconds / wall, baseWall / wall, worstJitter, meanSd, mismatches);
+    }
+    if (failures) printf("%d instance runs differ from the single-thread run: instances share state\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,208 @@
+// --- Worst-case step() search ---
+// Random search, then hill climbing, over the parameters that change what
+// step() does and the clock edge trains feeding it. Each candidate is replayed
+// a few times with identical inputs; its cost is the slowest block after
+// taking every block's fastest replay, so host scheduler noise does not win
+// the search. Reports the slowest configuration per factory.
+
+#include "host.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#define WARMUP_BLOCKS 32
+#define MEASURED_BLOCKS 128
+#define REPEATS 5
+
+// --- Search space ---
+// lo/hi of -1 take the parameter's own range; step spaces out bus choices
+// so routed inputs land on the generated buses 1-4 or on a spare output.
+
+struct SearchParam {
+    const char* name;
+    int lo, hi, step;
+};
+
+static const SearchParam searchParams[] = {
+    { "Scale", -1, -1, 1 }, { "MaskRot", -1, -1, 1 },
+    { "Note 1", -1, -1, 1 }, { "Note 2", -1, -1, 1 }, { "Note 3", -1, -1, 1 }, { "Note 4", -1, -1, 1 },
+    { "Note 5", -1, -1, 1 }, { "Note 6", -1, -1, 1 }, { "Note 7", -1, -1, 1 }, { "Note 8", -1, -1, 1 },
+    { "Note 9", -1, -1, 1 }, { "Note 10", -1, -1, 1 }, { "Note 11", -1, -1, 1 }, { "Note 12", -1, -1, 1 },
+    { "BufIdx", -1, -1, 1 }, { "BufLen", -1, -1, 1 },
+    { "CVSrc", -1, -1, 1 }, { "BB Eqn", -1, -1, 1 }, { "BB Rate", -1, -1, 1 }, { "BB CV1", -1, -1, 1 },
+    { "IntSeq", -1, -1, 1 }, { "IntSeqLen", -1, -1, 1 }, { "IntSeqStride", -1, -1, 1 },
+    { "MIDI Dest", -1, -1, 1 },
+    { "MIDI Ch A", -1, -1, 1 }, { "MIDI Ch B", -1, -1, 1 }, { "MIDI Ch C", -1, -1, 1 }, { "MIDI Ch D", -1, -1, 1 },
+    { "MIDI Ch E", -1, -1, 1 }, { "MIDI Ch F", -1, -1, 1 }, { "MIDI Ch G", -1, -1, 1 }, { "MIDI Ch H", -1, -1, 1 },
+    { "Mode", -1, -1, 1 }, { "Hyst", -1, -1, 1 }, { "TapPat", -1, -1, 1 }, { "Tap CV", 0, 4, 4 },
+    { "Rnd Lock", -1, -1, 1 },
+    { "Glide A", -1, -1, 1 }, { "Glide B", -1, -1, 1 }, { "Glide C", -1, -1, 1 }, { "Glide D", -1, -1, 1 },
+    { "Glide E", -1, -1, 1 }, { "Glide F", -1, -1, 1 }, { "Glide G", -1, -1, 1 }, { "Glide H", -1, -1, 1 },
+    { "Harmony", -1, -1, 1 }, { "Morph", -1, -1, 1 }, { "Scale B", -1, -1, 1 }, { "Morph Amt", -1, -1, 1 },
+    { "Morph CV", 0, 4, 4 }, { "Profile", -1, -1, 1 }, { "BB Out", 0, 21, 21 }, { "BB LPF", -1, -1, 1 },
+    { "MIDI In", -1, -1, 1 }, { "Detect", -1, -1, 1 },
+    { "Clk B", 0, 3, 1 }, { "Clk C", 0, 3, 1 }, { "Clk D", 0, 3, 1 }, { "Clk E", 0, 3, 1 },
+    { "Clk F", 0, 3, 1 }, { "Clk G", 0, 3, 1 }, { "Clk H", 0, 3, 1 },
+    { "Aud Quant", -1, -1, 1 },
+};
+
+#define NUM_SEARCH_PARAMS (int)(sizeof(searchParams) / sizeof(searchParams[0]))
+
+// Dimensions after the parameters: the ASR length and Audio mode
+// specifications and the inputs
+enum { DIM_SPEC, DIM_AUDIO_SPEC, DIM_CLOCK_PERIOD, DIM_CLOCK_PHASE, DIM_AUX_PERIOD, DIM_CV_SHAPE, NUM_INPUT_DIMS };
+
+static const char* inputDimNames[NUM_INPUT_DIMS] = { "ASR length", "Audio mode", "clock period", "clock phase", "aux period", "CV shape" };
+
+struct Dim {
+    const char* name;
+    int param;      // Parameter index, or -1 for an input dimension
+    int lo, hi, step;
+};
+
+struct Search {
+    const _NT_factory* factory;
+    Dim dims[NUM_SEARCH_PARAMS + NUM_INPUT_DIMS];
+    int numDims;
+    int framesPerBlock;
+    uint32_t rng;
+};
+
+static uint32_t next_random(Search& s) {
+    s.rng ^= s.rng << 13;
+    s.rng ^= s.rng >> 17;
+    s.rng ^= s.rng << 5;
+    return s.rng;
+}
+
+static int random_value(Search& s, const Dim& d) {
+    int steps = (d.hi - d.lo) / d.step;
+    return d.lo + (int)(next_random(s) % (steps + 1)) * d.step;
+}
+
+static void build_dims(Search& s) {
+    // Probed with every specification at its maximum, so each parameter shows
+    // its widest range
+    int32_t specs[HOST_MAX_SPECS] = { 0 };
+    for (int i = 0; i < s.factory->numSpecifications; ++i) specs[i] = s.factory->specifications[i].max;
+    HostInstance probe;
+    host_construct(probe, s.factory, specs);
+    s.numDims = 0;
+    for (int i = 0; i < NUM_SEARCH_PARAMS; ++i) {
+        int p = host_find_param(probe, searchParams[i].name);
+        if (p < 0) continue;
+        Dim& d = s.dims[s.numDims++];
+        d.name = searchParams[i].name;
+        d.param = p;
+        d.lo = searchParams[i].lo < 0 ? probe.alg->parameters[p].min : searchParams[i].lo;
+        d.hi = searchParams[i].hi < 0 ? probe.alg->parameters[p].max : searchParams[i].hi;
+        d.step = searchParams[i].step;
+    }
+    const _NT_specification& spec = s.factory->specifications[0];
+    const _NT_specification& audio = s.factory->specifications[1];
+    const int inputLo[NUM_INPUT_DIMS] = { spec.min, audio.min, 2, 0, 2, 0 };
+    const int inputHi[NUM_INPUT_DIMS] = { spec.max, audio.max, 512, 511, 512, HOST_NUM_CV_SHAPES - 1 };
+    for (int i = 0; i < NUM_INPUT_DIMS; ++i) {
+        Dim& d = s.dims[s.numDims++];
+        d.name = inputDimNames[i];
+        d.param = -1;
+        d.lo = inputLo[i];
+        d.hi = inputHi[i];
+        d.step = 1;
+    }
+}
+
+// --- Measurement ---
+
+static double measure(const Search& s, const int* cfg) {
+    const int* inputs = cfg + s.numDims - NUM_INPUT_DIMS;
+    int frames = s.framesPerBlock;
+    std::vector<float> buses(HOST_NUM_BUSES * frames, 0.0f);
+    std::vector<double> fastest(MEASURED_BLOCKS, 1e30);
+    for (int r = 0; r < REPEATS; ++r) {
+        HostInstance inst;
+        int32_t specs[HOST_MAX_SPECS] = { inputs[DIM_SPEC], inputs[DIM_AUDIO_SPEC] };
+        host_construct(inst, s.factory, specs);
+        for (int i = 0; i < s.numDims - NUM_INPUT_DIMS; ++i)
+            host_set_param(inst, s.dims[i].param, cfg[i]);
+
+        HostInputs in;
+        host_init_inputs(in, inputs[DIM_CLOCK_PERIOD], inputs[DIM_CLOCK_PHASE], inputs[DIM_AUX_PERIOD], inputs[DIM_CV_SHAPE], 12345);
+        for (int b = 0; b < WARMUP_BLOCKS + MEASURED_BLOCKS; ++b) {
+            host_fill_inputs(in, buses.data(), frames);
+            if (s.factory->midiMessage) s.factory->midiMessage(inst.alg, 0x90, 36 + b % 48, 100);
+            if (s.factory->draw) s.factory->draw(inst.alg); // Untimed, publishes Detect Apply's table
+            std::chrono::steady_clock::time_point t0 = std::chrono::steady_clock::now();
+            s.factory->step(inst.alg, buses.data(), frames / 4);
+            std::chrono::steady_clock::time_point t1 = std::chrono::steady_clock::now();
+            double ns = std::chrono::duration<double, std::nano>(t1 - t0).count();
+            if (b >= WARMUP_BLOCKS && ns < fastest[b - WARMUP_BLOCKS]) fastest[b - WARMUP_BLOCKS] = ns;
+        }
+    }
+    double worst = 0.0;
+    for (int b = 0; b < MEASURED_BLOCKS; ++b)
+        if (fastest[b] > worst) worst = fastest[b];
+    return worst;
+}
+
+// --- Search driver ---
+
+static void report(const Search& s, const int* cfg, double ns, int candidates) {
+    printf("%s: slowest block %.0f ns at %d frames (%.1f ns/frame), %d candidates\n",
+           s.factory->name, ns, s.framesPerBlock, ns / s.framesPerBlock, candidates);
+    for (int i = 0; i < s.numDims; ++i)
+        printf("  %s=%d%s", s.dims[i].name, cfg[i], (i % 6 == 5 || i == s.numDims - 1) ? "\n" : "");
+}
+
+static void search(const _NT_factory* factory, int framesPerBlock, int randomRuns, int climbSteps, uint32_t seed) {
+    Search s;
+    s.factory = factory;
+    s.framesPerBlock = framesPerBlock;
+    s.rng = seed ? seed : 1;
+    build_dims(s);
+
+    std::vector<int> best(s.numDims), cand(s.numDims);
+    double bestNs = -1.0;
+    for (int r = 0; r < randomRuns; ++r) {
+        for (int i = 0; i < s.numDims; ++i) cand[i] = random_value(s, s.dims[i]);
+        double ns = measure(s, cand.data());
+        if (ns > bestNs) { bestNs = ns; best = cand; }
+    }
+
+    // Hill climbing: nudge or redraw one dimension, keep it if slower
+    for (int c = 0; c < climbSteps; ++c) {
+        cand = best;
+        int i = next_random(s) % s.numDims;
+        const Dim& d = s.dims[i];
+        if (next_random(s) % 4 == 0) {
+            cand[i] = random_value(s, d);
+        } else {
+            int delta = d.step * (1 + (int)(next_random(s) % 3));
+            cand[i] += (next_random(s) & 1) ? delta : -delta;
+            if (cand[i] < d.lo) cand[i] = d.lo;
+            if (cand[i] > d.hi) cand[i] = d.hi;
+        }
+        double ns = measure(s, cand.data());
+        if (ns > bestNs) { bestNs = ns; best = cand; }
+    }
+    report(s, best.data(), bestNs, randomRuns + climbSteps);
+}
+
+int main(int argc, char** argv) {
+    int framesPerBlock = 32, randomRuns = 400, climbSteps = 1600;
+    uint32_t seed = 1;
+    for (int i = 1; i + 1 < argc; i += 2) {
+        if (!strcmp(argv[i], "-f")) framesPerBlock = atoi(argv[i + 1]) & ~3;
+        else if (!strcmp(argv[i], "-r")) randomRuns = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "-c")) climbSteps = atoi(argv[i + 1]);
+        else if (!strcmp(argv[i], "-s")) seed = atoi(argv[i + 1]);
+    }
+    if (framesPerBlock < 4) framesPerBlock = 4;
+    if (framesPerBlock > (int)NT_globals.maxFramesPerStep) framesPerBlock = NT_globals.maxFramesPerStep;
+
+    uint32_t numFactories = pluginEntry(kNT_selector_numFactories, 0);
+    for (uint32_t i = 0; i < numFactories; ++i)
+        search((const _NT_factory*)pluginEntry(kNT_selector_factoryInfo, i), framesPerBlock, randomRuns, climbSteps, seed);
+    return 0;
+}